@@ -0,0 +1,487 @@
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bfjit.h"
+#include "bfjit-codegen.h"
+#include "bfjit-compiler.h"
+#include "bfjit-io.h"
+#include "bfjit-memory.h"
+#include "bfjit-runtime.h"
+#include "bfjit-time.h"
+
+#ifndef BFJIT_BENCH_DIR
+#define BFJIT_BENCH_DIR "test"
+#endif
+
+#define BF_BENCH_TAPE_SIZE 30000
+
+// program of the test directory, run with canned input
+typedef struct {
+    const char* name;
+    const char* source;
+    const char* input;
+    const char* output_file;    // expected output, in a file or inline
+    const char* output;
+} bf_bench_program;
+
+static const bf_bench_program bf_bench_programs[] = {
+    {"mandelbrot", "mandelbrot.b", "", "mandelbrot-output.txt", NULL},
+    {"hanoi", "hanoi.b", "", "hanoi-output.txt", NULL},
+    {"long", "long.b", "", "long-output.txt", NULL},
+    {"factor", "factor.b", "43564138724\n", NULL, "43564138724: 2 2 23 307 1542421\n"},
+    {"life", "life.b", "cc\n\nq\n", "life-output.txt", NULL},
+    {"lost-kingdom", "lost-kingdom.b", "y\nq\ny\nn\n", "lost-kingdom-output.txt", NULL},
+};
+
+typedef struct {
+    const char* name;
+    int rtc;
+    int debug;
+} bf_bench_mode;
+
+static const bf_bench_mode bf_bench_modes[] = {
+    {"opt", BF_CHECK_INLINE, 0},
+    {"unsafe", BF_CHECK_NONE, 0},
+    {"debug", BF_CHECK_INLINE, 1},
+};
+
+#define BF_BENCH_PROGRAM_COUNT (sizeof(bf_bench_programs) / sizeof(bf_bench_programs[0]))
+#define BF_BENCH_MODE_COUNT (sizeof(bf_bench_modes) / sizeof(bf_bench_modes[0]))
+
+typedef enum {
+    BF_SINK_NULL,           // discards the output
+    BF_SINK_HASH,           // hashes the output and checks it against the expected one
+} bf_bench_sink;
+
+// median and 95th percentile of a measurement, in microseconds
+typedef struct {
+    double median;
+    double p95;
+} bf_bench_stats;
+
+typedef struct {
+    const bf_bench_program* program;
+    const bf_bench_mode* mode;
+    bf_bench_stats compile;
+    bf_bench_stats run;
+    uint64_t hash;
+    size_t code_size;
+    size_t peephole_bytes;  // left out of the code by the peephole rules
+} bf_bench_result;
+
+/*
+ *  Output sinks, which replace the flush_output function of the runtime
+ */
+
+#define BF_FNV_OFFSET 0xcbf29ce484222325ull
+#define BF_FNV_PRIME 0x100000001b3ull
+
+static uint64_t bf_fnv1a(uint64_t h, const unsigned char* data, size_t size)
+{
+    for (size_t i = 0; i != size; ++i)
+        h = (h ^ data[i]) * BF_FNV_PRIME;
+    return h;
+}
+
+typedef struct {
+    bf_runtime rt;          // first, so that the sink finds the rest from the context
+    uint64_t hash;
+} bf_bench_runtime;
+
+static void bf_bench_flush_null(bf_runtime_context* ctx)
+{
+    ctx->output_cur = ctx->output_buffer;
+}
+
+static void bf_bench_flush_hash(bf_runtime_context* ctx)
+{
+    bf_bench_runtime* brt = (bf_bench_runtime*)ctx;
+    brt->hash = bf_fnv1a(brt->hash, ctx->output_buffer, (size_t)(ctx->output_cur - ctx->output_buffer));
+    ctx->output_cur = ctx->output_buffer;
+}
+
+static uint64_t bf_hash_file(const char* filename)
+{
+    bf_file file = bf_open_file_read(filename);
+    unsigned char buffer[8 * 1024];
+    size_t read;
+    uint64_t h = BF_FNV_OFFSET;
+    while ((read = bf_read_file(file, buffer, sizeof(buffer))) != 0)
+        h = bf_fnv1a(h, buffer, read);
+    bf_close_file(file);
+    return h;
+}
+
+/*
+ *  Measurements
+ */
+
+static int bf_double_cmp(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// sorts 'samples'
+static bf_bench_stats bf_bench_compute_stats(double* samples, size_t count)
+{
+    qsort(samples, count, sizeof(double), bf_double_cmp);
+    bf_bench_stats stats;
+    stats.median = (count % 2 != 0) ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2;
+    // nearest rank
+    size_t rank = (count * 95 + 99) / 100;
+    stats.p95 = samples[rank - 1];
+    return stats;
+}
+
+// compiles and runs the program once, returns the hash of its output
+static uint64_t bf_bench_run_once(const char* source, const bf_bench_program* program, const bf_bench_mode* mode,
+                                  bf_bench_sink sink, double* compile_time, double* run_time,
+                                  size_t* code_size, size_t* peephole_bytes)
+{
+    int64_t t1 = bf_clock();
+    bf_jit_encoder* enc = bf_jit_encoder_new(mode->rtc, 0);
+    bf_compiled_code code;
+    if (mode->debug)
+    {
+        code = bf_compile_file_debug(source, enc);
+    }
+    else
+    {
+        bf_ir_options opts;
+        opts.opt_level = 2;
+        opts.rtc = mode->rtc;
+        opts.continued = 0;
+        opts.jobs = 0;
+        opts.eval_prefix = 1;
+        code = bf_compile_file(source, enc, &opts, NULL);
+    }
+    int64_t t2 = bf_clock();
+
+    void* mem = bf_jit_load(&code);
+    bf_compiled_func compiled_func = (bf_compiled_func)mem;
+
+    int64_t t3 = bf_clock();
+    bf_bench_runtime brt;
+    bf_runtime_init(&brt.rt, code.guard_size, BF_BENCH_TAPE_SIZE, NULL);
+    bf_runtime_set_input(&brt.rt, (const unsigned char*)program->input, strlen(program->input));
+    brt.rt.ctx.flush_output = (sink == BF_SINK_HASH) ? bf_bench_flush_hash : bf_bench_flush_null;
+    brt.hash = BF_FNV_OFFSET;
+    compiled_func(brt.rt.tape, &brt.rt.ctx);
+    bf_runtime_free(&brt.rt);
+    int64_t t4 = bf_clock();
+
+    *code_size = code.size;
+    *peephole_bytes = bf_jit_encoder_peephole(enc)->bytes;
+    bf_jit_encoder_free(enc);
+    bf_compiled_code_free(&code);
+
+    *compile_time = (double)(t2 - t1);
+    *run_time = (double)(t4 - t3);
+    return brt.hash;
+}
+
+static void bf_bench_measure(bf_bench_result* result, const char* dir, size_t warmup, size_t repeat,
+                             bf_bench_sink sink)
+{
+    const bf_bench_program* program = result->program;
+    char source[4096];
+    snprintf(source, sizeof(source), "%s/%s", dir, program->source);
+
+    uint64_t expected = BF_FNV_OFFSET;
+    if (sink == BF_SINK_HASH)
+    {
+        if (program->output_file)
+        {
+            char output_file[4096];
+            snprintf(output_file, sizeof(output_file), "%s/%s", dir, program->output_file);
+            expected = bf_hash_file(output_file);
+        }
+        else
+        {
+            expected = bf_fnv1a(expected, (const unsigned char*)program->output, strlen(program->output));
+        }
+    }
+
+    double* compile_times = bf_realloc(NULL, repeat * sizeof(double));
+    double* run_times = bf_realloc(NULL, repeat * sizeof(double));
+    for (size_t i = 0; i != warmup + repeat; ++i)
+    {
+        double compile_time, run_time;
+        uint64_t hash = bf_bench_run_once(source, program, result->mode, sink, &compile_time, &run_time,
+                                          &result->code_size, &result->peephole_bytes);
+        if (sink == BF_SINK_HASH && hash != expected)
+            bf_error("output of '%s' in %s mode differs from the expected one", program->name, result->mode->name);
+        result->hash = hash;
+        if (i >= warmup)
+        {
+            compile_times[i - warmup] = compile_time;
+            run_times[i - warmup] = run_time;
+        }
+    }
+    result->compile = bf_bench_compute_stats(compile_times, repeat);
+    result->run = bf_bench_compute_stats(run_times, repeat);
+    bf_free(compile_times);
+    bf_free(run_times);
+}
+
+/*
+ *  JSON reports, one result per line, which is what baselines are read back from
+ */
+
+static void bf_bench_write_json(FILE* file, const bf_bench_result* results, size_t count, size_t warmup,
+                                size_t repeat, bf_bench_sink sink)
+{
+    fprintf(file,
+            "{\n"
+            "  \"warmup\": %zu,\n"
+            "  \"repeat\": %zu,\n"
+            "  \"sink\": \"%s\",\n"
+            "  \"results\": [\n",
+            warmup, repeat, (sink == BF_SINK_HASH) ? "hash" : "null");
+    for (size_t i = 0; i != count; ++i)
+    {
+        const bf_bench_result* r = &results[i];
+        fprintf(file,
+                "    {\"program\": \"%s\", \"mode\": \"%s\", \"compile_median_ms\": %.3f, \"compile_p95_ms\": %.3f, "
+                "\"run_median_ms\": %.3f, \"run_p95_ms\": %.3f, \"code_size\": %zu, \"peephole_bytes\": %zu",
+                r->program->name, r->mode->name, r->compile.median / 1e3, r->compile.p95 / 1e3, r->run.median / 1e3,
+                r->run.p95 / 1e3, r->code_size, r->peephole_bytes);
+        if (sink == BF_SINK_HASH)
+            fprintf(file, ", \"output_hash\": \"%016" PRIx64 "\"", r->hash);
+        fprintf(file, "}%s\n", (i + 1 != count) ? "," : "");
+    }
+    fprintf(file,
+            "  ]\n"
+            "}\n");
+}
+
+static char* bf_read_text_file(const char* filename)
+{
+    bf_file file = bf_open_file_read(filename);
+    size_t size = 0;
+    size_t cap = 8 * 1024;
+    char* text = bf_realloc(NULL, cap);
+    size_t read;
+    while ((read = bf_read_file(file, text + size, cap - size - 1)) != 0)
+    {
+        size += read;
+        if (cap - size == 1)
+        {
+            cap *= 2;
+            text = bf_realloc(text, cap);
+        }
+    }
+    bf_close_file(file);
+    text[size] = '\0';
+    return text;
+}
+
+// returns the run median of 'result' in 'baseline' in microseconds, or a negative
+// value if the baseline doesn't have it
+static double bf_baseline_find(const char* baseline, const bf_bench_result* result)
+{
+    char key[256];
+    snprintf(key, sizeof(key), "{\"program\": \"%s\", \"mode\": \"%s\",", result->program->name,
+             result->mode->name);
+    const char* line = strstr(baseline, key);
+    if (!line)
+        return -1;
+    const char* end = strchr(line, '\n');
+    const char* field = strstr(line, "\"run_median_ms\": ");
+    if (!field || (end && field > end))
+        return -1;
+    return strtod(field + strlen("\"run_median_ms\": "), NULL) * 1e3;
+}
+
+// reports results slower than in 'baseline_file' by more than 'tolerance' percent,
+// returns their number
+static size_t bf_bench_check_baseline(const char* baseline_file, const bf_bench_result* results, size_t count,
+                                      double tolerance)
+{
+    char* baseline = bf_read_text_file(baseline_file);
+    size_t regressions = 0;
+    for (size_t i = 0; i != count; ++i)
+    {
+        const bf_bench_result* r = &results[i];
+        double base = bf_baseline_find(baseline, r);
+        if (base < 0)
+        {
+            fprintf(stderr, "%-13s %-7s not in baseline\n", r->program->name, r->mode->name);
+            continue;
+        }
+        double change = (base > 0) ? (r->run.median / base - 1) * 100 : 0;
+        int regressed = change > tolerance;
+        regressions += regressed;
+        fprintf(stderr, "%-13s %-7s %10.3f ms, baseline %10.3f ms, %+6.1f%%%s\n", r->program->name, r->mode->name,
+                r->run.median / 1e3, base / 1e3, change, regressed ? "  REGRESSION" : "");
+    }
+    bf_free(baseline);
+    return regressions;
+}
+
+static void bf_print_help(const char* argv0)
+{
+    printf("usage: %s [--repeat <number>] [--warmup <number>] [--sink null|hash] [--program <name>]...\n"
+           "  [--mode opt|unsafe|debug]... [--dir <directory>] [--json <filename>]\n"
+           "  [--baseline <filename>] [--tolerance <percent>]\n",
+           argv0);
+}
+
+static int bf_streq(const char* str1, const char* str2) { return strcmp(str1, str2) == 0; }
+
+static size_t bf_parse_count(const char* arg, const char* option, long long min)
+{
+    errno = 0;
+    char* end;
+    long long tmp = strtoll(arg, &end, 10);
+    if (*end != '\0' || errno != 0 || tmp < min)
+        bf_error("invalid argument to '%s' option", option);
+    return (size_t)tmp;
+}
+
+int main(int argc, char** argv)
+{
+    size_t repeat = 5;
+    size_t warmup = 1;
+    bf_bench_sink sink = BF_SINK_HASH;
+    int selected_programs[BF_BENCH_PROGRAM_COUNT] = {0};
+    int selected_modes[BF_BENCH_MODE_COUNT] = {0};
+    int any_program = 0;
+    int any_mode = 0;
+    const char* dir = BFJIT_BENCH_DIR;
+    const char* json_file = NULL;
+    const char* baseline_file = NULL;
+    double tolerance = 10;
+
+    for (int i = 1; i != argc; ++i)
+    {
+#define next_arg() do { if (++i == argc) bf_error("no argument to '%s' option", argv[i - 1]); } while (0)
+
+        if (bf_streq(argv[i], "--help") || bf_streq(argv[i], "-h"))
+        {
+            bf_print_help(argv[0]);
+            return 0;
+        }
+        else if (bf_streq(argv[i], "--repeat"))
+        {
+            next_arg();
+            repeat = bf_parse_count(argv[i], "--repeat", 1);
+        }
+        else if (bf_streq(argv[i], "--warmup"))
+        {
+            next_arg();
+            warmup = bf_parse_count(argv[i], "--warmup", 0);
+        }
+        else if (bf_streq(argv[i], "--sink"))
+        {
+            next_arg();
+            if (bf_streq(argv[i], "null"))
+                sink = BF_SINK_NULL;
+            else if (bf_streq(argv[i], "hash"))
+                sink = BF_SINK_HASH;
+            else
+                bf_error("invalid argument to '--sink' option (possible values: 'null', 'hash')");
+        }
+        else if (bf_streq(argv[i], "--program"))
+        {
+            next_arg();
+            size_t p = 0;
+            while (p != BF_BENCH_PROGRAM_COUNT && !bf_streq(argv[i], bf_bench_programs[p].name))
+                ++p;
+            if (p == BF_BENCH_PROGRAM_COUNT)
+                bf_error("unknown program: '%s'", argv[i]);
+            selected_programs[p] = 1;
+            any_program = 1;
+        }
+        else if (bf_streq(argv[i], "--mode"))
+        {
+            next_arg();
+            size_t m = 0;
+            while (m != BF_BENCH_MODE_COUNT && !bf_streq(argv[i], bf_bench_modes[m].name))
+                ++m;
+            if (m == BF_BENCH_MODE_COUNT)
+                bf_error("invalid argument to '--mode' option (possible values: 'opt', 'unsafe', 'debug')");
+            selected_modes[m] = 1;
+            any_mode = 1;
+        }
+        else if (bf_streq(argv[i], "--dir"))
+        {
+            next_arg();
+            dir = argv[i];
+        }
+        else if (bf_streq(argv[i], "--json"))
+        {
+            next_arg();
+            json_file = argv[i];
+        }
+        else if (bf_streq(argv[i], "--baseline"))
+        {
+            next_arg();
+            baseline_file = argv[i];
+        }
+        else if (bf_streq(argv[i], "--tolerance"))
+        {
+            next_arg();
+            char* end;
+            errno = 0;
+            tolerance = strtod(argv[i], &end);
+            if (*end != '\0' || errno != 0 || tolerance < 0)
+                bf_error("invalid argument to '--tolerance' option");
+        }
+        else
+        {
+            bf_error("unknown command line argument: '%s'", argv[i]);
+        }
+#undef next_arg
+    }
+
+    bf_bench_result* results = bf_realloc(NULL, BF_BENCH_PROGRAM_COUNT * BF_BENCH_MODE_COUNT * sizeof(bf_bench_result));
+    size_t count = 0;
+    for (size_t p = 0; p != BF_BENCH_PROGRAM_COUNT; ++p)
+    {
+        if (any_program && !selected_programs[p])
+            continue;
+        for (size_t m = 0; m != BF_BENCH_MODE_COUNT; ++m)
+        {
+            if (any_mode && !selected_modes[m])
+                continue;
+            bf_bench_result* r = &results[count++];
+            r->program = &bf_bench_programs[p];
+            r->mode = &bf_bench_modes[m];
+            bf_bench_measure(r, dir, warmup, repeat, sink);
+            fprintf(stderr, "%-13s %-7s compile %9.3f ms, run %10.3f ms (p95 %10.3f ms), code %8zu bytes\n",
+                    r->program->name, r->mode->name, r->compile.median / 1e3, r->run.median / 1e3, r->run.p95 / 1e3,
+                    r->code_size);
+        }
+    }
+
+    if (json_file)
+    {
+        FILE* file = fopen(json_file, "w");
+        if (!file)
+            bf_error("couldn't open file '%s'", json_file);
+        bf_bench_write_json(file, results, count, warmup, repeat, sink);
+        if (fclose(file) != 0)
+            bf_error("couldn't write file '%s'", json_file);
+    }
+    else
+    {
+        bf_bench_write_json(stdout, results, count, warmup, repeat, sink);
+    }
+
+    size_t regressions = 0;
+    if (baseline_file)
+    {
+        regressions = bf_bench_check_baseline(baseline_file, results, count, tolerance);
+        if (regressions != 0)
+            fprintf(stderr, "%zu of %zu results regressed by more than %.1f%%\n", regressions, count, tolerance);
+    }
+    bf_free(results);
+    return regressions != 0;
+}
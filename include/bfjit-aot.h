@@ -0,0 +1,12 @@
+#ifndef BFJIT_AOT_H
+#define BFJIT_AOT_H
+
+#include <stddef.h>
+
+#include "bfjit-codegen.h"
+
+// writes a static linux executable running 'code' with a tape of 'tape_size' cells,
+// the code must use the system v calling convention and must not rely on guard pages
+void bf_aot_write(const char* filename, const bf_compiled_code* code, size_t tape_size);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef BFJIT_BATCH_H
+#define BFJIT_BATCH_H
+
+#include <stddef.h>
+
+#include "bfjit-codegen.h"
+#include "bfjit-source.h"
+
+// input files of a batch
+typedef struct {
+    char** files;
+    size_t size;
+    size_t cap;
+    char* data;             // contents of the list, which the filenames point into
+} bf_batch_list;
+
+// reads a list with one filename per line, empty lines are skipped
+void bf_batch_list_load(bf_batch_list* list, const char* filename);
+void bf_batch_list_free(bf_batch_list* list);
+
+// runs 'code' loaded at 'mem' with every file of 'list' as its input on up to
+// 'threads' threads, each run has its own tape and writes its output to the
+// input filename followed by ".out", an error ends only the run it happens in
+// and is reported with the input filename, returns the number of failed runs
+size_t bf_batch_run(const bf_compiled_code* code, void* mem, size_t tapesize, const bf_batch_list* list,
+                    size_t threads, const bf_source_map* source_map);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef BFJIT_CACHE_H
+#define BFJIT_CACHE_H
+
+#include <stdint.h>
+
+#include "bfjit-codegen.h"
+
+// everything compiled code depends on
+typedef struct {
+    uint64_t source_hash;
+    uint64_t source_size;
+    int32_t opt_level;
+    int32_t rtc;
+    int32_t eof;
+    int32_t debug;
+    int32_t avx2;
+} bf_cache_key;
+
+void bf_cache_key_init(bf_cache_key* key, const char* source_file, int opt_level, int rtc, int eof, int debug);
+
+/*
+ *  Entries of the cache directory are files with the code at the start, so
+ *  that it can be mapped and run in place, followed by a trailer with the
+ *  key. Entries are written to a temporary file first and renamed, so that
+ *  concurrent runs see either a whole entry or none.
+ */
+
+// maps the code of the entry matching 'key', returns 0 if there is none
+int bf_cache_load(const char* dir, const bf_cache_key* key, bf_compiled_code* code);
+void bf_cache_store(const char* dir, const bf_cache_key* key, const bf_compiled_code* code);
+void bf_cache_unload(bf_compiled_code* code);
+// removes all entries from the directory
+void bf_cache_clear(const char* dir);
+
+#endif
@@ -1,41 +1,115 @@
 #ifndef BFJIT_CODEGEN_H
 #define BFJIT_CODEGEN_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 typedef struct {
     unsigned char* data;
     size_t size;
+    size_t guard_size;      // non-zero if the code relies on guard pages around the tape
+    size_t mapped_size;     // non-zero if data is an executable mapping of a cache entry
+    size_t osr_entry;       // non-zero if code at this offset enters the program in the middle
 } bf_compiled_code;
 
+// bounds checking modes
+enum {
+    BF_CHECK_NONE,
+    BF_CHECK_INLINE,        // compare pointer with tape bounds before accesses
+    BF_CHECK_GUARD,         // fault on guard pages, compare only for large jumps
+};
+
+// guard pages are sized to the largest static offset, within these limits
+#define BF_GUARD_MIN_SIZE 4096
+#define BF_GUARD_MAX_SIZE (1024 * 1024)
+
+// most cells a loop can keep in registers, fewer may be available on some platforms
+#define BF_MAX_CACHED_CELLS 8
+
 typedef struct bf_jit_encoder bf_jit_encoder;
 
+// instructions the encoder left out by looking at the ones before them
+typedef struct {
+    size_t flag_tests;      // tests of the current cell whose flags arithmetic on it already set
+    size_t bytes;           // code size they would have taken
+} bf_peephole_stats;
+
 bf_jit_encoder* bf_jit_encoder_new(int rtc, int eof);
 void bf_jit_encoder_free(bf_jit_encoder*);
 
+void bf_jit_encoder_set_guard_size(bf_jit_encoder* enc, size_t size);
+// AVX2 instructions are used if the running cpu supports them, unless disabled
+void bf_jit_encoder_set_avx2(bf_jit_encoder* enc, int avx2);
+/*
+ *  Code compiled with osr enabled has a second entry point at 'osr_entry':
+ *      void osr(unsigned char* ptr, bf_runtime_context* ctx, const void* entry)
+ *  It sets up the same state as the main one and jumps to 'entry', one of
+ *  the offsets returned by bf_jit_encode_osr_entry added to the code address.
+ */
+void bf_jit_encoder_set_osr(bf_jit_encoder* enc, int osr);
 void bf_jit_encoder_init(bf_jit_encoder* enc);
+// the code is freed with bf_compiled_code_free
 bf_compiled_code bf_jit_encoder_finish(bf_jit_encoder* enc);
+void bf_compiled_code_free(bf_compiled_code* code);
+// offset of the next instruction
+size_t bf_jit_encoder_offset(bf_jit_encoder* enc);
+// jumps get their final size when the code is finished, this maps an offset
+// returned before that into the finished code until the encoder is initialized again
+size_t bf_jit_encoder_relocate(const bf_jit_encoder* enc, size_t offset);
+// the same for offsets in increasing order, 'cursor' starts at zero
+size_t bf_jit_encoder_relocate_next(const bf_jit_encoder* enc, size_t offset, size_t* cursor);
+// of all code encoded so far, including appended parts
+const bf_peephole_stats* bf_jit_encoder_peephole(const bf_jit_encoder* enc);
+/*
+ *  Parts of a program can be encoded separately, even on other threads, with
+ *  encoders created for them from the encoder of the whole program, which
+ *  must be initialized and have its settings final. Parts don't assume
+ *  anything about the state of the program they start in, and must be
+ *  appended outside of all loops in program order.
+ */
+bf_jit_encoder* bf_jit_encoder_new_part(const bf_jit_encoder* enc);
+// returns the offset the code of the part starts at
+size_t bf_jit_encoder_append_part(bf_jit_encoder* enc, bf_jit_encoder* part);
+// offset of the next instruction as an osr entry, valid only where no cells are kept in registers
+size_t bf_jit_encode_osr_entry(bf_jit_encoder* enc);
 
 void bf_jit_encode_check(bf_jit_encoder* enc, int32_t count);
+// checks cell[x] whatever the mode, in place of an access that was left out
+void bf_jit_encode_probe(bf_jit_encoder* enc, int32_t x);
 void bf_jit_encode_next_unsafe(bf_jit_encoder* enc, int32_t count);
 void bf_jit_encode_next(bf_jit_encoder* enc, int32_t count);
 void bf_jit_encode_add(bf_jit_encoder* enc, int32_t count);
 void bf_jit_encode_input(bf_jit_encoder* enc);
 void bf_jit_encode_output(bf_jit_encoder* enc);
+void bf_jit_encode_output_repeat(bf_jit_encoder* enc, int32_t count);
+void bf_jit_encode_write(bf_jit_encoder* enc, const unsigned char* data, int32_t size);
+// copies 'size' bytes of 'data' to the cells from the pointer on, outside of loops
+void bf_jit_encode_init(bf_jit_encoder* enc, const unsigned char* data, int32_t size);
 void bf_jit_encode_offop_unsafe(bf_jit_encoder* enc, int32_t count, int32_t off);
 void bf_jit_encode_set(bf_jit_encoder* enc, int32_t val);
+void bf_jit_encode_set_offset_unsafe(bf_jit_encoder* enc, int32_t val, int32_t off);
 void bf_jit_encode_scanop(bf_jit_encoder* enc, int32_t off, int skip_init);
+// increments ctx->counters[counter]
+void bf_jit_encode_count(bf_jit_encoder* enc, uint32_t counter);
 
 void bf_jit_start_copy_seq(bf_jit_encoder* enc);
 void bf_jit_encode_copyop_unsafe(bf_jit_encoder* enc, int32_t off, int32_t mul);
+// adds the current cell times the cell at 'src' to the cell at 'off'
+void bf_jit_encode_productop_unsafe(bf_jit_encoder* enc, int32_t off, int32_t src);
 void bf_jit_finish_copy_seq(bf_jit_encoder* enc);
 
 void bf_jit_encode_loop_start(bf_jit_encoder* enc);
 void bf_jit_encode_loop_start_optimized(bf_jit_encoder* enc);
+// must precede loop head, cells at offsets 'offs' (in order of priority) are kept
+// in registers until the loop ends, the body must leave the pointer where it started
+// and must not move it onto any of the cells
+void bf_jit_encode_loop_cache_cells(bf_jit_encoder* enc, const int32_t* offs, size_t count);
+// pads the code before the loop head, for loops that run many iterations
+void bf_jit_encode_loop_align(bf_jit_encoder* enc);
+// iterations of the innermost loop start here, code between loop start and head runs once
+void bf_jit_encode_loop_head(bf_jit_encoder* enc);
 void bf_jit_encode_loop_end_optimized(bf_jit_encoder* enc);
 void bf_jit_encode_loop_end(bf_jit_encoder* enc);
-void bf_jit_pop_started_loop(bf_jit_encoder* enc);
-size_t bf_jit_current_loop_size(bf_jit_encoder* enc);
 int bf_jit_is_in_loop(bf_jit_encoder* enc);
 
 #endif
@@ -1,9 +1,40 @@
 #ifndef BFJIT_COMPILER_H
 #define BFJIT_COMPILER_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "bfjit-codegen.h"
+#include "bfjit-ir.h"
+#include "bfjit-perf.h"
+#include "bfjit-profile.h"
+#include "bfjit-source.h"
+
+// loop of the program that compiled code can be entered at
+typedef struct {
+    uint32_t src;       // source offset of the loop's '['
+    int32_t lo, hi;     // with bounds checking cells that must be in bounds on entry
+    size_t entry;       // code offset of the loop start
+} bf_osr_entry;
+
+typedef struct {
+    bf_osr_entry* entries;  // in code order
+    size_t size;
+    size_t cap;
+} bf_osr_table;
+
+// optional results of a compilation, each of them is skipped if NULL
+typedef struct {
+    bf_osr_table* osr;          // entries of all loops
+    bf_profile* profile;        // loops whose executions the code counts
+    bf_code_map* code_map;      // code of all loops
+    bf_source_map* source_map;  // source positions of all ops
+} bf_compile_info;
 
-bf_compiled_code bf_compile_file(const char* filename, bf_jit_encoder* enc);
+// optimizes and compiles parsed 'ir', 'info' may be NULL
+bf_compiled_code bf_compile_ir(bf_ir* ir, bf_jit_encoder* enc, const bf_ir_options* opts, const bf_compile_info* info);
+bf_compiled_code bf_compile_file(const char* filename, bf_jit_encoder* enc, const bf_ir_options* opts,
+                                 const bf_compile_info* info);
 bf_compiled_code bf_compile_file_debug(const char* filename, bf_jit_encoder* enc);
 
 #endif
@@ -0,0 +1,50 @@
+#ifndef BFJIT_CPU_H
+#define BFJIT_CPU_H
+
+#include <stdint.h>
+#if defined _MSC_VER && !defined __clang__
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// AVX2 instructions are supported by the cpu and ymm state is enabled by the os
+static int bf_cpu_has_avx2(void)
+{
+    uint32_t ebx, ecx;
+#if defined _MSC_VER && !defined __clang__
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7)
+        return 0;
+    __cpuid(regs, 1);
+    ecx = (uint32_t)regs[2];
+    __cpuidex(regs, 7, 0);
+    ebx = (uint32_t)regs[1];
+#else
+    uint32_t eax, edx;
+    if (__get_cpuid_max(0, NULL) < 7)
+        return 0;
+    __cpuid(1, eax, ebx, ecx, edx);
+    uint32_t features = ecx;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    ecx = features;
+#endif
+
+    const uint32_t osxsave = 1u << 27;
+    const uint32_t avx2 = 1u << 5;
+    if (!(ecx & osxsave) || !(ebx & avx2))
+        return 0;
+
+#if defined _MSC_VER && !defined __clang__
+    uint64_t xcr0 = _xgetbv(0);
+#else
+    uint32_t xcr0_lo, xcr0_hi;
+    __asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    uint64_t xcr0 = ((uint64_t)xcr0_hi << 32) | xcr0_lo;
+#endif
+    return (xcr0 & 6) == 6;
+}
+
+#endif
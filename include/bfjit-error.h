@@ -0,0 +1,18 @@
+#ifndef BFJIT_ERROR_H
+#define BFJIT_ERROR_H
+
+#include <setjmp.h>
+
+#define BF_ERROR_MESSAGE_SIZE 256
+
+typedef struct {
+    jmp_buf env;
+    char message[BF_ERROR_MESSAGE_SIZE];
+} bf_error_trap;
+
+// while a trap is set, errors on the calling thread store their message in it
+// and jump back to 'env' instead of exiting, NULL removes the trap, objects
+// the failed code was working on are left as they were at the error
+void bf_error_set_trap(bf_error_trap* trap);
+
+#endif
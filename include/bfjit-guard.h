@@ -0,0 +1,22 @@
+#ifndef BFJIT_GUARD_H
+#define BFJIT_GUARD_H
+
+#if defined _WIN32 || defined __linux__ || defined __APPLE__ || defined __FreeBSD__
+#define BF_HAVE_GUARD_PAGES 1
+#endif
+
+typedef struct {
+    unsigned char* begin;       // whole reserved region
+    unsigned char* end;
+    unsigned char* grow_begin;  // part of the region committed on first access,
+    unsigned char* grow_end;    // empty if the tape is committed up front
+} bf_guard_region;
+
+// while installed, memory faults of compiled code inside the region
+// commit the accessed pages of its growable part, and elsewhere are turned
+// into a call to ctx->out_of_bounds at the faulting instruction, every
+// thread installs at most one region and faults are handled on that thread
+void bf_guard_install(const bf_guard_region* region);
+void bf_guard_uninstall(void);
+
+#endif
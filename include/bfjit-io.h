@@ -9,12 +9,22 @@ typedef void* bf_file;
 typedef int bf_file;
 #endif
 
+#define BF_INVALID_FILE ((bf_file)-1)
+
 bf_file bf_open_file_read(const char* filename);
 bf_file bf_open_file_write(const char* filename);
+// returns BF_INVALID_FILE if the file can't be opened, the file can be mapped with bf_map_file_exec
+bf_file bf_try_open_file_exec(const char* filename);
+bf_file bf_stdin_file(void);
 size_t bf_read_file(bf_file file, void* buff, size_t size);
 void bf_write_file(bf_file file, void* data, size_t size);
 void bf_close_file(bf_file file);
 
+// maps a regular file for reading, returns NULL if the file can't be mapped
+void* bf_map_file(bf_file file, size_t* size);
+void* bf_map_file_exec(bf_file file, size_t* size);
+void bf_unmap_file(void* mem, size_t size);
+
 void bf_save_to_file(const char* filename, void* data, size_t size);
 
 #endif
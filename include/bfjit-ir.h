@@ -0,0 +1,100 @@
+#ifndef BFJIT_IR_H
+#define BFJIT_IR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Offsets are relative to the current value of the tape pointer.
+typedef enum {
+    BF_IR_ADD,          // cell[off] += val
+    BF_IR_SET,          // cell[off] = val
+    BF_IR_MOVE,         // ptr += val
+    BF_IR_INPUT,        // cell[0] = read()
+    BF_IR_OUTPUT,       // write(cell[0]) val times
+    BF_IR_LOOP,         // while (cell[0]) {  with bounds checking cells [off, val] are in bounds on entry
+    BF_IR_IF,           // if (cell[0]) {
+    BF_IR_END,          // }  of LOOP with bounds checking cells [off, val] stay in bounds on every iteration
+    BF_IR_SCAN,         // while (cell[0]) ptr += val
+    BF_IR_MUL,          // cell[off] += cell[0] * val
+    BF_IR_CHECK,        // bounds check of cells [off, val]
+    BF_IR_WRITE,        // write(data[off .. off + val])
+    BF_IR_PRODUCT,      // cell[off] += cell[0] * cell[val]
+    BF_IR_INIT,         // cell[0 .. val) = data[off .. off + val)
+} bf_ir_kind;
+
+enum {
+    BF_IR_ENTERED = 1,  // LOOP, IF, SCAN: cell[0] is known to be non-zero on entry
+    BF_IR_ONCE = 2,     // END of LOOP: cell[0] is known to be zero at the end of the body
+    BF_IR_HOISTED = 4,  // CHECK right after LOOP: done once on entry instead of every iteration
+    BF_IR_PROBE = 8,    // CHECK of cell[off] alone in place of an access a pass left out, done with guard pages too
+};
+
+typedef struct {
+    uint8_t kind;
+    uint8_t flags;
+    int32_t off;
+    int32_t val;
+    uint32_t link;      // LOOP, IF: index of matching END; END: index of matching LOOP or IF
+    uint32_t src;       // offset of the source character the op was parsed from, kept by passes copying ops;
+                        // ops replacing a loop have the offset of its '['
+} bf_ir_op;
+
+// source offset of ops created by passes
+#define BF_IR_NO_SRC UINT32_MAX
+
+typedef struct {
+    uint32_t begin;     // index of LOOP or IF op
+    uint32_t end;       // index of matching END op
+    int32_t parent;     // index of enclosing loop, -1 at top level
+    uint32_t depth;
+    int innermost;
+} bf_ir_loop;
+
+typedef struct {
+    bf_ir_op* ops;
+    size_t size;
+    size_t cap;
+    bf_ir_loop* loops;
+    size_t loops_size;
+    size_t loops_cap;
+    unsigned char* data;    // constant output of WRITE ops and cells of INIT ops
+    size_t data_size;
+    size_t data_cap;
+    uint32_t* lines;        // source offsets where the lines after the first one start
+    size_t lines_size;
+    size_t lines_cap;
+} bf_ir;
+
+typedef struct {
+    int opt_level;
+    int rtc;            // bounds checking mode, one of BF_CHECK_* from bfjit-codegen.h
+    int continued;      // ops continue a program, nothing is known about the tape they start with
+    size_t jobs;        // threads compiling parts of the program, 0 for one per cpu
+    int eval_prefix;    // run the program up to its first input at compile time
+} bf_ir_options;
+
+void bf_ir_init(bf_ir* ir);
+void bf_ir_free(bf_ir* ir);
+void bf_ir_swap(bf_ir* a, bf_ir* b);
+
+size_t bf_ir_push(bf_ir* ir, bf_ir_kind kind, int32_t off, int32_t val);
+void bf_ir_push_op(bf_ir* ir, const bf_ir_op* op);
+// appends 'count' copies of a byte to the constant data, returns offset of the first one
+size_t bf_ir_push_data(bf_ir* ir, unsigned char value, size_t count);
+// appends 'count' bytes to the constant data, returns offset of the first one
+size_t bf_ir_push_bytes(bf_ir* ir, const unsigned char* bytes, size_t count);
+
+// recomputes 'link' fields and the loop tree, must be called after a pass rewrites ops
+void bf_ir_link(bf_ir* ir);
+// passes rewrite ops of 'ir' into 'out', which takes over the constant data
+// and the lines, and then replace 'ir' with the linked result
+void bf_ir_init_pass(bf_ir* out, bf_ir* ir);
+void bf_ir_replace(bf_ir* ir, bf_ir* out);
+
+void bf_ir_parse_file(const char* filename, bf_ir* ir);
+// line and column of a source offset, both starting at 1
+void bf_ir_source_position(const bf_ir* ir, uint32_t src, uint32_t* line, uint32_t* col);
+
+void bf_ir_optimize(bf_ir* ir, const bf_ir_options* opts);
+
+#endif
@@ -8,6 +8,10 @@ void* bf_realloc(void* ptr, size_t newsize);
 void bf_free(void* ptr);
 
 void* bf_virtual_alloc(size_t size);
+// reserves inaccessible address space, parts of it are made usable with bf_virtual_commit
+void* bf_virtual_reserve(size_t size);
+void bf_virtual_commit(void* mem, size_t size);
+size_t bf_page_size(void);
 void bf_virtual_make_exe(void* mem, size_t size);
 void bf_virtual_free(void* mem, size_t size);
 
@@ -0,0 +1,44 @@
+#ifndef BFJIT_PERF_H
+#define BFJIT_PERF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined __linux__
+#define BF_HAVE_PERF 1
+#endif
+
+// code of a loop, from its start to the end of its last iteration
+typedef struct {
+    size_t begin;           // code offsets
+    size_t end;
+    uint32_t line;          // of the '['
+    uint32_t col;
+} bf_code_region;
+
+typedef struct {
+    bf_code_region* regions;    // in order of 'begin', containing loops before nested ones
+    size_t size;
+    size_t cap;
+} bf_code_map;
+
+void bf_code_map_init(bf_code_map* map);
+void bf_code_map_free(bf_code_map* map);
+// 'end' is filled in later, when the loop ends
+size_t bf_code_map_push(bf_code_map* map, size_t begin, uint32_t line, uint32_t col);
+// appends regions of code placed at 'base'
+void bf_code_map_append(bf_code_map* map, const bf_code_map* part, size_t base);
+
+/*
+ *  Symbols for perf. Every byte of code loaded at 'mem' is attributed to the
+ *  innermost loop containing it, named "loop@L<line>:C<col>", other code is
+ *  named "program".
+ */
+
+// writes /tmp/perf-<pid>.map, which perf reads on its own
+void bf_perf_write_map(const bf_code_map* map, const unsigned char* mem, size_t size);
+// writes /tmp/jit-<pid>.dump with the code and source lines of the symbols,
+// 'perf record -k mono' followed by 'perf inject --jit' picks it up
+void bf_perf_write_jitdump(const bf_code_map* map, const unsigned char* mem, size_t size, const char* source_file);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef BFJIT_PROFILE_H
+#define BFJIT_PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bfjit-ir.h"
+
+// how a loop of the source was compiled
+typedef enum {
+    BF_PROFILE_REMOVED,     // into no code of its own, it is never entered or became straight-line code
+    BF_PROFILE_LOOP,
+    BF_PROFILE_SCAN,
+    BF_PROFILE_COPY,        // adds multiples of the cell to others
+    BF_PROFILE_SET,
+} bf_profile_kind;
+
+// loop 'i' counts its entries in counters[2 * i], compiled loops also count
+// iterations of their body in counters[2 * i + 1]
+typedef struct {
+    uint32_t src;           // source offset of the '['
+    uint32_t line;
+    uint32_t col;
+    bf_profile_kind kind;
+} bf_profile_loop;
+
+typedef struct {
+    bf_profile_loop* loops; // in source order
+    size_t size;
+    uint64_t* counters;
+} bf_profile;
+
+// collects loops of the parsed 'ir', before it is optimized
+void bf_profile_init(bf_profile* profile, const bf_ir* ir);
+void bf_profile_free(bf_profile* profile);
+// index of the loop starting at 'src', -1 if there is none
+int64_t bf_profile_find(const bf_profile* profile, uint32_t src);
+// prints the most executed loops
+void bf_profile_report(const bf_profile* profile);
+
+#endif
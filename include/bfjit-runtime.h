@@ -2,15 +2,99 @@
 #define BFJIT_RUNTIME_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "bfjit-codegen.h"
+#include "bfjit-io.h"
+#include "bfjit-source.h"
 
-void bf_runtime_out_of_bounds();
-unsigned char bf_runtime_read_char_eof_zero(void);
-unsigned char bf_runtime_read_char_eof_minusone(void);
-unsigned char bf_runtime_read_char_eof_nochange(unsigned char old);
-void bf_runtime_write_char(unsigned char val);
+// zeroed bytes allocated on both sides of the tape, so that vectorized
+// scans can read whole blocks around its ends
+#define BF_TAPE_PADDING 32
 
-void bf_jit_run(bf_compiled_code* code, size_t memsize);
+// tape size of a tape committed on demand in both directions,
+// requires code compiled with guard pages
+#define BF_TAPE_UNBOUNDED 0
+
+// address space reserved for the unbounded tape, the pointer starts in its middle
+#define BF_UNBOUNDED_TAPE_RESERVE ((size_t)1 << 36)
+
+// must be a power of two, the output buffer is aligned to its size
+#define BF_OUTPUT_BUFFER_SIZE 4096
+
+#define BF_INPUT_BUFFER_SIZE (64 * 1024)
+
+typedef struct bf_runtime_context bf_runtime_context;
+
+// passed to compiled code, which reaches the runtime only through it,
+// so the code doesn't contain any absolute addresses
+struct bf_runtime_context {
+    void (*flush_output)(bf_runtime_context* ctx);
+    void (*write_output)(bf_runtime_context* ctx, const unsigned char* data, size_t size);
+    void (*fill_output)(bf_runtime_context* ctx, unsigned char value, size_t size);
+    void (*out_of_bounds)(bf_runtime_context* ctx, const unsigned char* ptr, const unsigned char* pc);
+    unsigned char (*read_char_eof_zero)(bf_runtime_context* ctx);
+    unsigned char (*read_char_eof_minusone)(bf_runtime_context* ctx);
+    unsigned char (*read_char_eof_nochange)(bf_runtime_context* ctx, unsigned char old);
+    unsigned char* output_cur;
+    unsigned char* output_buffer;
+    // bounds of the tape for checked code
+    unsigned char* tape_begin;
+    unsigned char* tape_end;
+    unsigned char* tape_start;      // where the pointer starts, cells are numbered from it
+    // compiled code consumes bytes in [input_cur, input_end) inline and calls
+    // one of the read_char functions only when the range is exhausted
+    const unsigned char* input_cur;
+    const unsigned char* input_end;
+    // counters of code compiled with profiling
+    uint64_t* counters;
+    // source positions of the code starting at 'code' for errors, NULL if there are none
+    const bf_source_map* source_map;
+    const unsigned char* code;
+    unsigned char* input_buffer;
+    void* input_map;
+    size_t input_map_size;
+    bf_file input_file;
+    int input_eof;
+};
+
+void bf_runtime_flush_output(bf_runtime_context* ctx);
+void bf_runtime_write_output(bf_runtime_context* ctx, const unsigned char* data, size_t size);
+void bf_runtime_fill_output(bf_runtime_context* ctx, unsigned char value, size_t size);
+// 'ptr' is the tape pointer, 'pc' is in the code that failed the access or NULL
+void bf_runtime_out_of_bounds(bf_runtime_context* ctx, const unsigned char* ptr, const unsigned char* pc);
+unsigned char bf_runtime_read_char_eof_zero(bf_runtime_context* ctx);
+unsigned char bf_runtime_read_char_eof_minusone(bf_runtime_context* ctx);
+unsigned char bf_runtime_read_char_eof_nochange(bf_runtime_context* ctx, unsigned char old);
+
+// program being run, by compiled code or otherwise
+typedef struct {
+    bf_runtime_context ctx;
+    unsigned char* tape;        // initial position of the pointer
+    unsigned char* memory;
+    size_t memory_size;
+    size_t guard_size;
+    const char* input_filename;
+} bf_runtime;
+
+// the tape is surrounded by guard pages of at least 'guard_size' bytes if it
+// is non-zero, its end right against the upper ones, program input is read from 'input_filename' or stdin if it is NULL
+void bf_runtime_init(bf_runtime* rt, size_t guard_size, size_t tapesize, const char* input_filename);
+// flushes the output through ctx.flush_output, which may be replaced after init
+void bf_runtime_free(bf_runtime* rt);
+// replaces the rest of the input with 'size' bytes at 'data' followed by eof,
+// the bytes must outlive the runtime
+void bf_runtime_set_input(bf_runtime* rt, const unsigned char* data, size_t size);
+
+typedef void (*bf_compiled_func)(unsigned char* tape, bf_runtime_context* ctx);
+
+// returns the executable code, which runs in place and isn't writable afterwards
+void* bf_jit_load(const bf_compiled_code* code);
+
+// runs 'code' loaded at 'mem', reads program input from 'input_filename' or stdin
+// if it is NULL, 'counters' is required by code compiled with profiling, errors
+// are reported at positions of 'source_map' if it isn't NULL
+void bf_jit_run(const bf_compiled_code* code, void* mem, size_t memsize, const char* input_filename,
+                uint64_t* counters, const bf_source_map* source_map);
 
 #endif
@@ -0,0 +1,44 @@
+#ifndef BFJIT_SOURCE_H
+#define BFJIT_SOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// commands of a source file, everything else is a comment
+typedef struct {
+    unsigned char* commands;    // one of "+-<>.,[]" each
+    uint32_t* offsets;          // source offset of each command
+    size_t size;
+    size_t cap;
+    uint32_t* lines;            // source offsets where the lines after the first one start
+    size_t lines_size;
+    size_t lines_cap;
+} bf_source;
+
+// lexes the file, which is mapped if possible, reports unmatched brackets
+void bf_source_load(bf_source* source, const char* filename);
+void bf_source_free(bf_source* source);
+
+// source position of code from 'offset' up to the next position
+typedef struct {
+    size_t offset;
+    uint32_t line;
+    uint32_t col;
+} bf_source_pos;
+
+// source positions of compiled code, for errors of the running program
+typedef struct {
+    bf_source_pos* positions;   // in code order
+    size_t size;
+    size_t cap;
+} bf_source_map;
+
+void bf_source_map_init(bf_source_map* map);
+void bf_source_map_free(bf_source_map* map);
+void bf_source_map_push(bf_source_map* map, size_t offset, uint32_t line, uint32_t col);
+// appends positions of code placed at 'base'
+void bf_source_map_append(bf_source_map* map, const bf_source_map* part, size_t base);
+// returns 0 if code at 'offset' precedes all positions
+int bf_source_map_find(const bf_source_map* map, size_t offset, uint32_t* line, uint32_t* col);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef BFJIT_THREAD_H
+#define BFJIT_THREAD_H
+
+#include <stddef.h>
+
+#ifdef _MSC_VER
+// volatile accesses have acquire and release semantics on x64 with the default /volatile:ms
+#define bf_load_acquire(p) (*(volatile const int*)(p))
+#define bf_store_release(p, v) (*(volatile int*)(p) = (v))
+#else
+#define bf_load_acquire(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define bf_store_release(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+#ifdef _MSC_VER
+#define BF_THREAD_LOCAL __declspec(thread)
+#else
+#define BF_THREAD_LOCAL _Thread_local
+#endif
+
+typedef void* bf_thread;
+
+typedef void (*bf_thread_func)(void* arg);
+typedef void (*bf_parallel_func)(void* arg, size_t index);
+
+bf_thread bf_thread_start(bf_thread_func func, void* arg);
+void bf_thread_join(bf_thread thread);
+size_t bf_cpu_count(void);
+
+// calls 'func' with every index in [0, count) on up to 'threads' threads,
+// the calling one included, which pick the next index as they become free
+void bf_parallel_for(size_t count, size_t threads, bf_parallel_func func, void* arg);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef BFJIT_TIERED_H
+#define BFJIT_TIERED_H
+
+#include <stddef.h>
+
+#include "bfjit-codegen.h"
+#include "bfjit-ir.h"
+
+/*
+ *  Runs the program in 'filename' with an interpreter right after parsing,
+ *  while another thread compiles it. Once the code is ready the program
+ *  continues in it from the next iteration of a loop. Returns the compiled
+ *  code, which is always completed so that it can be cached. The tape is
+ *  checked by explicit comparisons, guard pages are not supported.
+ */
+bf_compiled_code bf_run_tiered(const char* filename, bf_jit_encoder* enc, const bf_ir_options* opts, int eof,
+                               size_t tapesize, const char* input_filename);
+
+#endif
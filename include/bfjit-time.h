@@ -3,7 +3,7 @@
 
 #include <stdint.h>
 
-// epoch time in microseconds
+// monotonic time in microseconds since an unspecified point, for measuring intervals
 int64_t bf_clock(void);
 
 #endif
@@ -8,11 +8,18 @@
 #error "Unsupported architecture"
 #endif
 
-#define bf_error(...)                               \
-    do {                                            \
-        fprintf(stderr, "error: " __VA_ARGS__);     \
-        fputc('\n', stderr);                        \
-        exit(1);                                    \
-    } while (0)
+#if defined _MSC_VER
+#define BF_NORETURN __declspec(noreturn)
+#define BF_PRINTF_FORMAT
+#else
+#define BF_NORETURN __attribute__((noreturn))
+#define BF_PRINTF_FORMAT __attribute__((format(printf, 1, 2)))
+#endif
+
+// reports the error and exits, or ends the run of the calling thread if it
+// has set an error trap, see bfjit-error.h
+BF_NORETURN void bf_fail(const char* format, ...) BF_PRINTF_FORMAT;
+
+#define bf_error(...) bf_fail(__VA_ARGS__)
 
 #endif
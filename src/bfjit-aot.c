@@ -0,0 +1,494 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include "bfjit.h"
+#include "bfjit-aot.h"
+#include "bfjit-io.h"
+#include "bfjit-memory.h"
+#include "bfjit-runtime.h"
+
+/*
+ *  The executable has a read-only and executable segment with the headers,
+ *  a minimal runtime and the compiled code, and a writable one with the
+ *  runtime context. The context is initialized in the file, the output and
+ *  input buffers and the tape follow it and are zero filled by the loader.
+ *  The runtime talks to the kernel with system calls only, so the executable
+ *  depends on nothing else.
+ */
+
+#define BF_AOT_BASE 0x400000
+#define BF_AOT_PAGE 4096
+#define BF_AOT_HEADERS_SIZE (64 + 3 * 56)
+
+// linux system call numbers
+#define BF_SYS_READ 0
+#define BF_SYS_WRITE 1
+#define BF_SYS_EXIT_GROUP 231
+
+enum {
+    BF_AOT_START,
+    BF_AOT_FLUSH_OUTPUT,
+    BF_AOT_WRITE_OUTPUT,
+    BF_AOT_FILL_OUTPUT,
+    BF_AOT_OUT_OF_BOUNDS,
+    BF_AOT_READ_CHAR,
+    BF_AOT_READ_CHAR_EOF_ZERO,
+    BF_AOT_READ_CHAR_EOF_MINUSONE,
+    BF_AOT_READ_CHAR_EOF_NOCHANGE,
+    BF_AOT_FAIL,
+    BF_AOT_MSG_WRITE,
+    BF_AOT_MSG_READ,
+    BF_AOT_MSG_BOUNDS,
+    BF_AOT_CODE,
+    BF_AOT_LABELS_COUNT,
+    // local labels of a single function, reused by each of them
+    BF_AOT_LOCAL1 = BF_AOT_LABELS_COUNT,
+    BF_AOT_LOCAL2,
+    BF_AOT_LOCAL3,
+    BF_AOT_LOCAL4,
+    BF_AOT_ALL_LABELS_COUNT
+};
+
+#define BF_AOT_MAX_FIXUPS 64
+
+typedef struct {
+    unsigned char* data;
+    size_t size;
+    size_t cap;
+    size_t labels[BF_AOT_ALL_LABELS_COUNT];
+    // positions of rel32 displacements, and labels they refer to
+    size_t fixups[BF_AOT_MAX_FIXUPS];
+    int fixup_labels[BF_AOT_MAX_FIXUPS];
+    size_t fixups_size;
+} bf_aot_buffer;
+
+static void aot_write_byte(bf_aot_buffer* b, unsigned char byte)
+{
+    if (b->size == b->cap)
+    {
+        b->cap = (b->cap == 0) ? 4096 : b->cap * 2;
+        b->data = bf_realloc(b->data, b->cap);
+    }
+    b->data[b->size++] = byte;
+}
+
+static void aot_write_byte2(bf_aot_buffer* b, unsigned char b1, unsigned char b2)
+{
+    aot_write_byte(b, b1);
+    aot_write_byte(b, b2);
+}
+
+static void aot_write_byte3(bf_aot_buffer* b, unsigned char b1, unsigned char b2, unsigned char b3)
+{
+    aot_write_byte(b, b1);
+    aot_write_byte(b, b2);
+    aot_write_byte(b, b3);
+}
+
+static void aot_write_data(bf_aot_buffer* b, const void* data, size_t size)
+{
+    for (size_t i = 0; i != size; ++i)
+        aot_write_byte(b, ((const unsigned char*)data)[i]);
+}
+
+static void aot_write_u16(bf_aot_buffer* b, uint16_t v)
+{
+    for (int i = 0; i != 2; ++i)
+        aot_write_byte(b, (unsigned char)(v >> (8 * i)));
+}
+
+static void aot_write_u32(bf_aot_buffer* b, uint32_t v)
+{
+    for (int i = 0; i != 4; ++i)
+        aot_write_byte(b, (unsigned char)(v >> (8 * i)));
+}
+
+static void aot_write_u64(bf_aot_buffer* b, uint64_t v)
+{
+    for (int i = 0; i != 8; ++i)
+        aot_write_byte(b, (unsigned char)(v >> (8 * i)));
+}
+
+static void aot_put_u64(unsigned char* p, uint64_t v)
+{
+    for (int i = 0; i != 8; ++i)
+        p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static void aot_label(bf_aot_buffer* b, int label)
+{
+    b->labels[label] = b->size;
+}
+
+// displacement relative to the end of the instruction, which ends with it
+static void aot_write_rel32(bf_aot_buffer* b, int label)
+{
+    if (b->fixups_size == BF_AOT_MAX_FIXUPS)
+        bf_error("too many fixups");
+    b->fixups[b->fixups_size] = b->size;
+    b->fixup_labels[b->fixups_size++] = label;
+    aot_write_u32(b, 0);
+}
+
+// local labels are resolved at the end of each function, before they are reused
+static void aot_resolve(bf_aot_buffer* b, int first_label, int last_label)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i != b->fixups_size; ++i)
+    {
+        int label = b->fixup_labels[i];
+        if (label < first_label || label >= last_label)
+        {
+            b->fixups[kept] = b->fixups[i];
+            b->fixup_labels[kept++] = label;
+            continue;
+        }
+        uint32_t disp = (uint32_t)(b->labels[label] - (b->fixups[i] + 4));
+        for (int j = 0; j != 4; ++j)
+            b->data[b->fixups[i] + j] = (unsigned char)(disp >> (8 * j));
+    }
+    b->fixups_size = kept;
+}
+
+static void aot_resolve_locals(bf_aot_buffer* b)
+{
+    aot_resolve(b, BF_AOT_LOCAL1, BF_AOT_ALL_LABELS_COUNT);
+}
+
+// <op> reg, [rbx+<off>] with a 64-bit operand if 'rex_w'
+static void aot_rbx_op(bf_aot_buffer* b, int rex_w, unsigned char opcode, unsigned reg, size_t off)
+{
+    if (rex_w)
+        aot_write_byte(b, 0x48);
+    aot_write_byte2(b, opcode, (unsigned char)(0x83 | (reg << 3)));
+    aot_write_u32(b, (uint32_t)off);
+}
+
+static void aot_jcc(bf_aot_buffer* b, unsigned char cc, int label)
+{
+    aot_write_byte2(b, 0x0F, cc);
+    aot_write_rel32(b, label);
+}
+
+static void aot_jmp(bf_aot_buffer* b, int label)
+{
+    aot_write_byte(b, 0xE9);
+    aot_write_rel32(b, label);
+}
+
+static void aot_call(bf_aot_buffer* b, int label)
+{
+    aot_write_byte(b, 0xE8);
+    aot_write_rel32(b, label);
+}
+
+static void aot_syscall(bf_aot_buffer* b, uint32_t number)
+{
+    aot_write_byte(b, 0xB8);
+    aot_write_u32(b, number);                                           // mov  eax, <number>
+    aot_write_byte2(b, 0x0F, 0x05);                                     // syscall
+}
+
+// jumps to fail with the message in rsi and its length in edx
+static void aot_fail(bf_aot_buffer* b, int msg, uint32_t len)
+{
+    aot_write_byte3(b, 0x48, 0x8D, 0x35);
+    aot_write_rel32(b, msg);                                            // lea  rsi, [rip+<msg>]
+    aot_write_byte(b, 0xBA);
+    aot_write_u32(b, len);                                              // mov  edx, <len>
+    aot_jmp(b, BF_AOT_FAIL);
+}
+
+#define BF_RBX_OP(b, w, opcode, reg, field) aot_rbx_op(b, w, opcode, reg, offsetof(bf_runtime_context, field))
+
+static const char bf_aot_msg_write[] = "error: couldn't write output\n";
+static const char bf_aot_msg_read[] = "error: couldn't read from file\n";
+static const char bf_aot_msg_bounds[] = "error: out of bounds memory access\n";
+
+static void aot_runtime_flush_output(bf_aot_buffer* b)
+{
+    aot_label(b, BF_AOT_FLUSH_OUTPUT);
+    aot_write_byte(b, 0x53);                                            // push rbx
+    aot_write_byte3(b, 0x48, 0x89, 0xFB);                               // mov  rbx, rdi
+    BF_RBX_OP(b, 1, 0x8B, 6, output_buffer);                            // mov  rsi, [rbx+output_buffer]
+    BF_RBX_OP(b, 1, 0x8B, 2, output_cur);                               // mov  rdx, [rbx+output_cur]
+    aot_write_byte3(b, 0x48, 0x29, 0xF2);                               // sub  rdx, rsi
+    aot_label(b, BF_AOT_LOCAL1);                                        // loop:
+    aot_write_byte3(b, 0x48, 0x85, 0xD2);                               // test rdx, rdx
+    aot_jcc(b, 0x84, BF_AOT_LOCAL2);                                    // jz   done
+    aot_write_byte(b, 0xBF);
+    aot_write_u32(b, 1);                                                // mov  edi, 1
+    aot_syscall(b, BF_SYS_WRITE);
+    aot_write_byte3(b, 0x48, 0x85, 0xC0);                               // test rax, rax
+    aot_jcc(b, 0x8E, BF_AOT_LOCAL3);                                    // jle  error
+    aot_write_byte3(b, 0x48, 0x01, 0xC6);                               // add  rsi, rax
+    aot_write_byte3(b, 0x48, 0x29, 0xC2);                               // sub  rdx, rax
+    aot_jmp(b, BF_AOT_LOCAL1);                                          // jmp  loop
+    aot_label(b, BF_AOT_LOCAL2);                                        // done:
+    BF_RBX_OP(b, 1, 0x8B, 0, output_buffer);                            // mov  rax, [rbx+output_buffer]
+    BF_RBX_OP(b, 1, 0x89, 0, output_cur);                               // mov  [rbx+output_cur], rax
+    aot_write_byte(b, 0x5B);                                            // pop  rbx
+    aot_write_byte(b, 0xC3);                                            // ret
+    aot_label(b, BF_AOT_LOCAL3);                                        // error:
+    aot_fail(b, BF_AOT_MSG_WRITE, sizeof(bf_aot_msg_write) - 1);
+    aot_resolve_locals(b);
+}
+
+// bytes are copied one by one, the buffer is flushed as soon as it fills up
+static void aot_runtime_write_output(bf_aot_buffer* b, int fill)
+{
+    aot_label(b, fill ? BF_AOT_FILL_OUTPUT : BF_AOT_WRITE_OUTPUT);
+    aot_write_byte(b, 0x53);                                            // push rbx
+    aot_write_byte2(b, 0x41, 0x54);                                     // push r12
+    aot_write_byte2(b, 0x41, 0x55);                                     // push r13
+    aot_write_byte3(b, 0x48, 0x89, 0xFB);                               // mov  rbx, rdi
+    aot_write_byte3(b, 0x49, 0x89, 0xF4);                               // mov  r12, rsi
+    aot_write_byte3(b, 0x49, 0x89, 0xD5);                               // mov  r13, rdx
+    aot_label(b, BF_AOT_LOCAL1);                                        // loop:
+    aot_write_byte3(b, 0x4D, 0x85, 0xED);                               // test r13, r13
+    aot_jcc(b, 0x84, BF_AOT_LOCAL2);                                    // jz   done
+    BF_RBX_OP(b, 1, 0x8B, 0, output_cur);                               // mov  rax, [rbx+output_cur]
+    if (fill)
+    {
+        aot_write_byte3(b, 0x44, 0x88, 0x20);                           // mov  [rax], r12b
+    }
+    else
+    {
+        aot_write_byte2(b, 0x41, 0x8A);
+        aot_write_byte2(b, 0x0C, 0x24);                                 // mov  cl, [r12]
+        aot_write_byte2(b, 0x88, 0x08);                                 // mov  [rax], cl
+        aot_write_byte3(b, 0x49, 0xFF, 0xC4);                           // inc  r12
+    }
+    aot_write_byte3(b, 0x48, 0xFF, 0xC0);                               // inc  rax
+    BF_RBX_OP(b, 1, 0x89, 0, output_cur);                               // mov  [rbx+output_cur], rax
+    aot_write_byte3(b, 0x49, 0xFF, 0xCD);                               // dec  r13
+    aot_write_byte(b, 0xA9);
+    aot_write_u32(b, BF_OUTPUT_BUFFER_SIZE - 1);                        // test eax, <size - 1>
+    aot_jcc(b, 0x85, BF_AOT_LOCAL1);                                    // jnz  loop
+    aot_write_byte3(b, 0x48, 0x89, 0xDF);                               // mov  rdi, rbx
+    aot_call(b, BF_AOT_FLUSH_OUTPUT);                                   // call flush_output
+    aot_jmp(b, BF_AOT_LOCAL1);                                          // jmp  loop
+    aot_label(b, BF_AOT_LOCAL2);                                        // done:
+    aot_write_byte2(b, 0x41, 0x5D);                                     // pop  r13
+    aot_write_byte2(b, 0x41, 0x5C);                                     // pop  r12
+    aot_write_byte(b, 0x5B);                                            // pop  rbx
+    aot_write_byte(b, 0xC3);                                            // ret
+    aot_resolve_locals(b);
+}
+
+static void aot_runtime_out_of_bounds(bf_aot_buffer* b)
+{
+    aot_label(b, BF_AOT_OUT_OF_BOUNDS);
+    aot_call(b, BF_AOT_FLUSH_OUTPUT);                                   // call flush_output
+    aot_fail(b, BF_AOT_MSG_BOUNDS, sizeof(bf_aot_msg_bounds) - 1);
+}
+
+// refills the input buffer, returns the next input byte or -1 in eax
+static void aot_runtime_read_char(bf_aot_buffer* b)
+{
+    aot_label(b, BF_AOT_READ_CHAR);
+    aot_write_byte(b, 0x53);                                            // push rbx
+    aot_write_byte3(b, 0x48, 0x89, 0xFB);                               // mov  rbx, rdi
+    // output written so far must be visible before the program waits for input
+    BF_RBX_OP(b, 1, 0x8B, 0, output_cur);                               // mov  rax, [rbx+output_cur]
+    BF_RBX_OP(b, 1, 0x3B, 0, output_buffer);                            // cmp  rax, [rbx+output_buffer]
+    aot_jcc(b, 0x84, BF_AOT_LOCAL1);                                    // je   read
+    aot_call(b, BF_AOT_FLUSH_OUTPUT);                                   // call flush_output
+    aot_label(b, BF_AOT_LOCAL1);                                        // read:
+    BF_RBX_OP(b, 0, 0x83, 7, input_eof);
+    aot_write_byte(b, 0x00);                                            // cmp  dword ptr [rbx+input_eof], 0
+    aot_jcc(b, 0x85, BF_AOT_LOCAL2);                                    // jne  eof
+    aot_write_byte2(b, 0x31, 0xFF);                                     // xor  edi, edi
+    BF_RBX_OP(b, 1, 0x8B, 6, input_buffer);                             // mov  rsi, [rbx+input_buffer]
+    aot_write_byte(b, 0xBA);
+    aot_write_u32(b, BF_INPUT_BUFFER_SIZE);                             // mov  edx, <size>
+    aot_syscall(b, BF_SYS_READ);
+    aot_write_byte3(b, 0x48, 0x85, 0xC0);                               // test rax, rax
+    aot_jcc(b, 0x88, BF_AOT_LOCAL3);                                    // js   error
+    aot_jcc(b, 0x84, BF_AOT_LOCAL4);                                    // jz   set_eof
+    aot_write_byte2(b, 0x48, 0x8D);
+    aot_write_byte2(b, 0x14, 0x06);                                     // lea  rdx, [rsi+rax]
+    BF_RBX_OP(b, 1, 0x89, 2, input_end);                                // mov  [rbx+input_end], rdx
+    aot_write_byte2(b, 0x48, 0x8D);
+    aot_write_byte2(b, 0x56, 0x01);                                     // lea  rdx, [rsi+1]
+    BF_RBX_OP(b, 1, 0x89, 2, input_cur);                                // mov  [rbx+input_cur], rdx
+    aot_write_byte3(b, 0x0F, 0xB6, 0x06);                               // movzx eax, byte ptr [rsi]
+    aot_write_byte(b, 0x5B);                                            // pop  rbx
+    aot_write_byte(b, 0xC3);                                            // ret
+    aot_label(b, BF_AOT_LOCAL4);                                        // set_eof:
+    BF_RBX_OP(b, 0, 0xC7, 0, input_eof);
+    aot_write_u32(b, 1);                                                // mov  dword ptr [rbx+input_eof], 1
+    aot_label(b, BF_AOT_LOCAL2);                                        // eof:
+    aot_write_byte(b, 0xB8);
+    aot_write_u32(b, (uint32_t)-1);                                     // mov  eax, -1
+    aot_write_byte(b, 0x5B);                                            // pop  rbx
+    aot_write_byte(b, 0xC3);                                            // ret
+    aot_label(b, BF_AOT_LOCAL3);                                        // error:
+    aot_fail(b, BF_AOT_MSG_READ, sizeof(bf_aot_msg_read) - 1);
+    aot_resolve_locals(b);
+
+    aot_label(b, BF_AOT_READ_CHAR_EOF_ZERO);
+    aot_call(b, BF_AOT_READ_CHAR);                                      // call read_char
+    aot_write_byte2(b, 0x85, 0xC0);                                     // test eax, eax
+    aot_write_byte2(b, 0x79, 0x02);                                     // jns  done
+    aot_write_byte2(b, 0x31, 0xC0);                                     // xor  eax, eax
+    aot_write_byte(b, 0xC3);                                            // done: ret
+
+    // low byte of -1 is the value for eof
+    aot_label(b, BF_AOT_READ_CHAR_EOF_MINUSONE);
+    aot_jmp(b, BF_AOT_READ_CHAR);                                       // jmp  read_char
+
+    aot_label(b, BF_AOT_READ_CHAR_EOF_NOCHANGE);
+    aot_write_byte(b, 0x53);                                            // push rbx
+    aot_write_byte2(b, 0x89, 0xF3);                                     // mov  ebx, esi
+    aot_call(b, BF_AOT_READ_CHAR);                                      // call read_char
+    aot_write_byte2(b, 0x85, 0xC0);                                     // test eax, eax
+    aot_write_byte3(b, 0x0F, 0x48, 0xC3);                               // cmovs eax, ebx
+    aot_write_byte(b, 0x5B);                                            // pop  rbx
+    aot_write_byte(b, 0xC3);                                            // ret
+}
+
+static void aot_write_elf_header(bf_aot_buffer* b, uint64_t entry)
+{
+    static const unsigned char ident[16] = {0x7F, 'E', 'L', 'F', 2, 1, 1};
+    aot_write_data(b, ident, sizeof(ident));                            // 64-bit, little endian, current version
+    aot_write_u16(b, 2);                                                // executable
+    aot_write_u16(b, 62);                                               // x86-64
+    aot_write_u32(b, 1);
+    aot_write_u64(b, entry);
+    aot_write_u64(b, 64);                                               // program headers follow
+    aot_write_u64(b, 0);                                                // no sections
+    aot_write_u32(b, 0);
+    aot_write_u16(b, 64);
+    aot_write_u16(b, 56);
+    aot_write_u16(b, 3);
+    aot_write_u16(b, 64);
+    aot_write_u16(b, 0);
+    aot_write_u16(b, 0);
+}
+
+static void aot_write_program_header(bf_aot_buffer* b, uint32_t type, uint32_t flags, uint64_t offset,
+                                     uint64_t filesz, uint64_t memsz)
+{
+    aot_write_u32(b, type);
+    aot_write_u32(b, flags);
+    aot_write_u64(b, offset);
+    aot_write_u64(b, BF_AOT_BASE + offset);
+    aot_write_u64(b, BF_AOT_BASE + offset);
+    aot_write_u64(b, filesz);
+    aot_write_u64(b, memsz);
+    aot_write_u64(b, BF_AOT_PAGE);
+}
+
+static uint64_t aot_round_up(uint64_t size, uint64_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+void bf_aot_write(const char* filename, const bf_compiled_code* code, size_t tape_size)
+{
+    bf_aot_buffer b;
+    memset(&b, 0, sizeof(b));
+    b.cap = 4096;
+    b.data = bf_zero_alloc(b.cap);
+    b.size = BF_AOT_HEADERS_SIZE;
+
+    // addresses of the writable segment are only known once the size of the
+    // code is, 'start' loads them from the end of the text
+    size_t addrs = b.size;
+    b.size += 2 * 8;
+    aot_label(&b, BF_AOT_START);
+    aot_write_byte3(&b, 0x48, 0x8B, 0x3D);
+    aot_write_u32(&b, (uint32_t)(addrs - (b.size + 4)));                // mov  rdi, [rip+<tape>]
+    aot_write_byte3(&b, 0x48, 0x8B, 0x35);
+    aot_write_u32(&b, (uint32_t)(addrs + 8 - (b.size + 4)));            // mov  rsi, [rip+<ctx>]
+    aot_call(&b, BF_AOT_CODE);                                          // call code
+    aot_write_byte3(&b, 0x48, 0x8B, 0x3D);
+    aot_write_u32(&b, (uint32_t)(addrs + 8 - (b.size + 4)));            // mov  rdi, [rip+<ctx>]
+    aot_call(&b, BF_AOT_FLUSH_OUTPUT);                                  // call flush_output
+    aot_write_byte2(&b, 0x31, 0xFF);                                    // xor  edi, edi
+    aot_syscall(&b, BF_SYS_EXIT_GROUP);
+
+    aot_label(&b, BF_AOT_FAIL);
+    aot_write_byte(&b, 0xBF);
+    aot_write_u32(&b, 2);                                               // mov  edi, 2
+    aot_syscall(&b, BF_SYS_WRITE);
+    aot_write_byte(&b, 0xBF);
+    aot_write_u32(&b, 1);                                               // mov  edi, 1
+    aot_syscall(&b, BF_SYS_EXIT_GROUP);
+
+    aot_runtime_flush_output(&b);
+    aot_runtime_write_output(&b, 0);
+    aot_runtime_write_output(&b, 1);
+    aot_runtime_out_of_bounds(&b);
+    aot_runtime_read_char(&b);
+
+    aot_label(&b, BF_AOT_MSG_WRITE);
+    aot_write_data(&b, bf_aot_msg_write, sizeof(bf_aot_msg_write) - 1);
+    aot_label(&b, BF_AOT_MSG_READ);
+    aot_write_data(&b, bf_aot_msg_read, sizeof(bf_aot_msg_read) - 1);
+    aot_label(&b, BF_AOT_MSG_BOUNDS);
+    aot_write_data(&b, bf_aot_msg_bounds, sizeof(bf_aot_msg_bounds) - 1);
+
+    // compiled code starts on its own page, as it does when run by the jit
+    while (b.size % BF_AOT_PAGE != 0)
+        aot_write_byte(&b, 0xCC);
+    aot_label(&b, BF_AOT_CODE);
+    aot_write_data(&b, code->data, code->size);
+    aot_resolve(&b, 0, BF_AOT_ALL_LABELS_COUNT);
+    size_t text_size = b.size;
+
+    uint64_t data_off = aot_round_up(text_size, BF_AOT_PAGE);
+    uint64_t ctx_addr = BF_AOT_BASE + data_off;
+    uint64_t output_addr = aot_round_up(ctx_addr + sizeof(bf_runtime_context), BF_OUTPUT_BUFFER_SIZE);
+    uint64_t input_addr = output_addr + BF_OUTPUT_BUFFER_SIZE;
+    uint64_t tape_addr = input_addr + BF_INPUT_BUFFER_SIZE + BF_TAPE_PADDING;
+    uint64_t data_end = tape_addr + tape_size + BF_TAPE_PADDING;
+
+    while (b.size != data_off)
+        aot_write_byte(&b, 0);
+    unsigned char ctx[sizeof(bf_runtime_context)];
+    memset(ctx, 0, sizeof(ctx));
+#define BF_AOT_CTX(field, value) aot_put_u64(ctx + offsetof(bf_runtime_context, field), (value))
+#define BF_AOT_FUNC(field, label) BF_AOT_CTX(field, BF_AOT_BASE + b.labels[label])
+    BF_AOT_FUNC(flush_output, BF_AOT_FLUSH_OUTPUT);
+    BF_AOT_FUNC(write_output, BF_AOT_WRITE_OUTPUT);
+    BF_AOT_FUNC(fill_output, BF_AOT_FILL_OUTPUT);
+    BF_AOT_FUNC(out_of_bounds, BF_AOT_OUT_OF_BOUNDS);
+    BF_AOT_FUNC(read_char_eof_zero, BF_AOT_READ_CHAR_EOF_ZERO);
+    BF_AOT_FUNC(read_char_eof_minusone, BF_AOT_READ_CHAR_EOF_MINUSONE);
+    BF_AOT_FUNC(read_char_eof_nochange, BF_AOT_READ_CHAR_EOF_NOCHANGE);
+    BF_AOT_CTX(output_cur, output_addr);
+    BF_AOT_CTX(output_buffer, output_addr);
+    BF_AOT_CTX(tape_begin, tape_addr);
+    BF_AOT_CTX(tape_end, tape_addr + tape_size);
+    BF_AOT_CTX(input_buffer, input_addr);
+    // input_cur and input_end are null, the first input calls read_char
+#undef BF_AOT_FUNC
+#undef BF_AOT_CTX
+    aot_write_data(&b, ctx, sizeof(ctx));
+
+    aot_put_u64(b.data + addrs, tape_addr);
+    aot_put_u64(b.data + addrs + 8, ctx_addr);
+
+    bf_aot_buffer headers;
+    memset(&headers, 0, sizeof(headers));
+    aot_write_elf_header(&headers, BF_AOT_BASE + b.labels[BF_AOT_START]);
+    aot_write_program_header(&headers, 1, 5, 0, text_size, text_size);  // text, read and execute
+    aot_write_program_header(&headers, 1, 6, data_off, sizeof(ctx), data_end - ctx_addr);
+    aot_write_program_header(&headers, 0x6474E551, 6, 0, 0, 0);        // non-executable stack
+    assert(headers.size == BF_AOT_HEADERS_SIZE);
+    memcpy(b.data, headers.data, headers.size);
+    bf_free(headers.data);
+
+    bf_save_to_file(filename, b.data, b.size);
+#ifndef _WIN32
+    chmod(filename, 0755);
+#endif
+    bf_free(b.data);
+}
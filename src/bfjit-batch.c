@@ -0,0 +1,155 @@
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bfjit.h"
+#include "bfjit-batch.h"
+#include "bfjit-error.h"
+#include "bfjit-io.h"
+#include "bfjit-memory.h"
+#include "bfjit-runtime.h"
+#include "bfjit-thread.h"
+
+static void bf_batch_list_push(bf_batch_list* list, char* file)
+{
+    if (list->size == list->cap)
+    {
+        list->cap = (list->cap == 0) ? 64 : (list->cap * 2);
+        list->files = bf_realloc(list->files, list->cap * sizeof(char*));
+    }
+    list->files[list->size++] = file;
+}
+
+void bf_batch_list_load(bf_batch_list* list, const char* filename)
+{
+    list->files = NULL;
+    list->size = 0;
+    list->cap = 0;
+
+    bf_file file = bf_open_file_read(filename);
+    size_t cap = 4096;
+    size_t size = 0;
+    size_t read;
+    list->data = bf_realloc(NULL, cap);
+    // one byte is kept free for the terminator of the last line
+    while ((read = bf_read_file(file, list->data + size, cap - size - 1)) != 0)
+    {
+        size += read;
+        if (size + 1 == cap)
+        {
+            cap *= 2;
+            list->data = bf_realloc(list->data, cap);
+        }
+    }
+    bf_close_file(file);
+    list->data[size] = '\n';
+
+    char* line = list->data;
+    for (char* p = list->data; p != list->data + size + 1; ++p)
+    {
+        if (*p != '\n')
+            continue;
+        char* end = p;
+        if (end != line && end[-1] == '\r')
+            --end;
+        *end = '\0';
+        if (end != line)
+            bf_batch_list_push(list, line);
+        line = p + 1;
+    }
+}
+
+void bf_batch_list_free(bf_batch_list* list)
+{
+    bf_free(list->files);
+    bf_free(list->data);
+}
+
+typedef struct {
+    const bf_compiled_code* code;
+    void* mem;
+    size_t tapesize;
+    const bf_batch_list* list;
+    const bf_source_map* source_map;
+    unsigned char* failed;  // by input
+} bf_batch;
+
+// state of a run the error path looks at, it isn't a local variable so that
+// it keeps its values after the jump back to the trap
+typedef struct {
+    bf_runtime rt;          // first, so that the flush function finds the rest from the context
+    bf_error_trap trap;
+    bf_file output;
+    int running;            // 'rt' is initialized
+} bf_batch_run_state;
+
+static void bf_batch_flush_output(bf_runtime_context* ctx)
+{
+    bf_batch_run_state* run = (bf_batch_run_state*)ctx;
+    size_t size = (size_t)(ctx->output_cur - ctx->output_buffer);
+    // the buffer is emptied first, an error writing it doesn't flush it again
+    ctx->output_cur = ctx->output_buffer;
+    if (size != 0)
+        bf_write_file(run->output, ctx->output_buffer, size);
+}
+
+static void bf_batch_run_one(void* arg, size_t index)
+{
+    bf_batch* batch = arg;
+    const char* input = batch->list->files[index];
+    size_t input_size = strlen(input);
+    char* output = bf_realloc(NULL, input_size + sizeof(".out"));
+    memcpy(output, input, input_size);
+    memcpy(output + input_size, ".out", sizeof(".out"));
+
+    bf_batch_run_state* run = bf_realloc(NULL, sizeof(bf_batch_run_state));
+    run->output = BF_INVALID_FILE;
+    run->running = 0;
+    if (setjmp(run->trap.env) == 0)
+    {
+        bf_error_set_trap(&run->trap);
+        bf_runtime_init(&run->rt, batch->code->guard_size, batch->tapesize, input);
+        run->running = 1;
+        run->output = bf_open_file_write(output);
+        run->rt.ctx.flush_output = bf_batch_flush_output;
+        run->rt.ctx.source_map = batch->source_map;
+        run->rt.ctx.code = batch->mem;
+        ((bf_compiled_func)batch->mem)(run->rt.tape, &run->rt.ctx);
+        bf_runtime_free(&run->rt);
+        run->running = 0;
+        bf_error_set_trap(NULL);
+    }
+    else
+    {
+        fprintf(stderr, "error: %s: %s\n", input, run->trap.message);
+        if (run->running)
+        {
+            // output after the error is dropped, as the program would have exited
+            run->rt.ctx.output_cur = run->rt.ctx.output_buffer;
+            bf_runtime_free(&run->rt);
+        }
+        batch->failed[index] = 1;
+    }
+    if (run->output != BF_INVALID_FILE)
+        bf_close_file(run->output);
+    bf_free(run);
+    bf_free(output);
+}
+
+size_t bf_batch_run(const bf_compiled_code* code, void* mem, size_t tapesize, const bf_batch_list* list,
+                    size_t threads, const bf_source_map* source_map)
+{
+    bf_batch batch;
+    batch.code = code;
+    batch.mem = mem;
+    batch.tapesize = tapesize;
+    batch.list = list;
+    batch.source_map = source_map;
+    batch.failed = bf_zero_alloc(list->size + 1);
+    bf_parallel_for(list->size, threads, bf_batch_run_one, &batch);
+    size_t failed = 0;
+    for (size_t i = 0; i != list->size; ++i)
+        failed += batch.failed[i];
+    bf_free(batch.failed);
+    return failed;
+}
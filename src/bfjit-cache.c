@@ -0,0 +1,252 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "bfjit.h"
+#include "bfjit-cache.h"
+#include "bfjit-cpu.h"
+#include "bfjit-io.h"
+#include "bfjit-memory.h"
+
+// stored in entries, increment when their layout changes
+#define BF_CACHE_VERSION 1
+
+#define BF_CACHE_EXT ".bfc"
+
+typedef struct {
+    char magic[8];
+    bf_cache_key key;
+    uint64_t compiler;
+    uint64_t code_size;
+    uint64_t guard_size;
+} bf_cache_trailer;
+
+static uint64_t bf_hash_mix(uint64_t h, uint64_t v)
+{
+    h = (h ^ v) * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+}
+
+static uint64_t bf_hash_bytes(uint64_t h, const unsigned char* data, size_t size)
+{
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        uint64_t v;
+        memcpy(&v, data, 8);
+        h = bf_hash_mix(h, v);
+    }
+    return h;
+}
+
+void bf_cache_key_init(bf_cache_key* key, const char* source_file, int opt_level, int rtc, int eof, int debug)
+{
+    memset(key, 0, sizeof(*key));
+    key->opt_level = opt_level;
+    key->rtc = rtc;
+    key->eof = eof;
+    key->debug = debug;
+    key->avx2 = bf_cpu_has_avx2();
+
+    bf_file file = bf_open_file_read(source_file);
+    unsigned char buffer[8 * 1024];
+    size_t size = 0;
+    size_t read;
+    uint64_t h = 0;
+    do
+    {
+        read = bf_read_file(file, buffer + size, sizeof(buffer) - size);
+        key->source_size += read;
+        size += read;
+        // whole words are hashed, the rest waits for the next read
+        h = bf_hash_bytes(h, buffer, size);
+        memmove(buffer, buffer + size / 8 * 8, size % 8);
+        size %= 8;
+    } while (read != 0);
+    bf_close_file(file);
+
+    memset(buffer + size, 0, 8 - size);
+    key->source_hash = bf_hash_bytes(h, buffer, 8);
+}
+
+/*
+ *  Entries of a compiler that was rebuilt or replaced must not be used, so
+ *  the size and modification time of its executable go into the trailer.
+ *  Where they are not available stale entries have to be cleared by hand.
+ */
+static uint64_t bf_cache_compiler_stamp(void)
+{
+#if defined _WIN32
+    char path[MAX_PATH];
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    DWORD len = GetModuleFileNameA(NULL, path, MAX_PATH);
+    if (len == 0 || len == MAX_PATH || !GetFileAttributesExA(path, GetFileExInfoStandard, &data))
+        return 0;
+    uint64_t h = bf_hash_mix(data.nFileSizeHigh, data.nFileSizeLow);
+    h = bf_hash_mix(h, data.ftLastWriteTime.dwHighDateTime);
+    return bf_hash_mix(h, data.ftLastWriteTime.dwLowDateTime);
+#elif defined __linux__
+    struct stat st;
+    if (stat("/proc/self/exe", &st) != 0)
+        return 0;
+    uint64_t h = bf_hash_mix((uint64_t)st.st_size, (uint64_t)st.st_mtim.tv_sec);
+    return bf_hash_mix(h, (uint64_t)st.st_mtim.tv_nsec);
+#else
+    return 0;
+#endif
+}
+
+static void bf_cache_trailer_init(bf_cache_trailer* trailer, const bf_cache_key* key)
+{
+    memset(trailer, 0, sizeof(*trailer));
+    memcpy(trailer->magic, "bfjitc", 6);
+    trailer->magic[6] = BF_CACHE_VERSION;
+    memcpy(&trailer->key, key, sizeof(*key));
+    trailer->compiler = bf_cache_compiler_stamp();
+}
+
+// returns a path allocated with bf_realloc
+static char* bf_cache_path(const char* dir, const char* name, const char* ext)
+{
+    size_t size = strlen(dir) + strlen(name) + strlen(ext) + 2;
+    char* path = bf_realloc(NULL, size);
+    snprintf(path, size, "%s/%s%s", dir, name, ext);
+    return path;
+}
+
+static char* bf_cache_entry_path(const char* dir, const bf_cache_trailer* trailer)
+{
+    uint64_t h = bf_hash_bytes(0, (const unsigned char*)&trailer->key, sizeof(trailer->key));
+    h = bf_hash_mix(h, trailer->compiler);
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)h);
+    return bf_cache_path(dir, name, BF_CACHE_EXT);
+}
+
+int bf_cache_load(const char* dir, const bf_cache_key* key, bf_compiled_code* code)
+{
+    bf_cache_trailer expected;
+    bf_cache_trailer_init(&expected, key);
+    char* path = bf_cache_entry_path(dir, &expected);
+    bf_file file = bf_try_open_file_exec(path);
+    bf_free(path);
+    if (file == BF_INVALID_FILE)
+        return 0;
+
+    size_t size;
+    unsigned char* mem = bf_map_file_exec(file, &size);
+    bf_close_file(file);
+    if (!mem)
+        return 0;
+
+    // entries with a matching name but a different key are collisions
+    bf_cache_trailer trailer;
+    if (size >= sizeof(trailer))
+        memcpy(&trailer, mem + size - sizeof(trailer), sizeof(trailer));
+    if (size < sizeof(trailer) || memcmp(&trailer, &expected, offsetof(bf_cache_trailer, code_size)) != 0 ||
+        trailer.code_size != size - sizeof(trailer))
+    {
+        bf_unmap_file(mem, size);
+        return 0;
+    }
+
+    code->data = mem;
+    code->size = (size_t)trailer.code_size;
+    code->guard_size = (size_t)trailer.guard_size;
+    code->mapped_size = size;
+    code->osr_entry = 0;
+    return 1;
+}
+
+void bf_cache_store(const char* dir, const bf_cache_key* key, const bf_compiled_code* code)
+{
+    bf_cache_trailer trailer;
+    bf_cache_trailer_init(&trailer, key);
+    trailer.code_size = code->size;
+    trailer.guard_size = code->guard_size;
+
+    char* path = bf_cache_entry_path(dir, &trailer);
+    size_t tmp_size = strlen(path) + 32;
+    char* tmp_path = bf_realloc(NULL, tmp_size);
+#ifdef _WIN32
+    CreateDirectoryA(dir, NULL);
+    snprintf(tmp_path, tmp_size, "%s.%lu.tmp", path, (unsigned long)GetCurrentProcessId());
+#else
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST)
+        bf_error("couldn't create cache directory '%s'", dir);
+    snprintf(tmp_path, tmp_size, "%s.%ld.tmp", path, (long)getpid());
+#endif
+
+    bf_file file = bf_open_file_write(tmp_path);
+    bf_write_file(file, code->data, code->size);
+    bf_write_file(file, &trailer, sizeof(trailer));
+    bf_close_file(file);
+
+    // fails on windows while another process maps the entry, which then has the same contents
+#ifdef _WIN32
+    if (!MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING))
+        DeleteFileA(tmp_path);
+#else
+    if (rename(tmp_path, path) != 0)
+        unlink(tmp_path);
+#endif
+    bf_free(tmp_path);
+    bf_free(path);
+}
+
+void bf_cache_unload(bf_compiled_code* code)
+{
+    bf_unmap_file(code->data, code->mapped_size);
+    code->data = NULL;
+    code->mapped_size = 0;
+}
+
+static int bf_cache_is_entry(const char* name)
+{
+    size_t len = strlen(name);
+    size_t ext_len = strlen(BF_CACHE_EXT);
+    return len > ext_len && strcmp(name + len - ext_len, BF_CACHE_EXT) == 0;
+}
+
+void bf_cache_clear(const char* dir)
+{
+#ifdef _WIN32
+    char* pattern = bf_cache_path(dir, "*", BF_CACHE_EXT);
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(pattern, &data);
+    bf_free(pattern);
+    if (find == INVALID_HANDLE_VALUE)
+        return;
+    do
+    {
+        char* path = bf_cache_path(dir, data.cFileName, "");
+        if (bf_cache_is_entry(data.cFileName) && !DeleteFileA(path))
+            bf_error("couldn't remove cache entry '%s'", path);
+        bf_free(path);
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+#else
+    DIR* d = opendir(dir);
+    if (!d)
+        return;
+    struct dirent* ent;
+    while ((ent = readdir(d)) != NULL)
+    {
+        char* path = bf_cache_path(dir, ent->d_name, "");
+        if (bf_cache_is_entry(ent->d_name) && unlink(path) != 0)
+            bf_error("couldn't remove cache entry '%s'", path);
+        bf_free(path);
+    }
+    closedir(d);
+#endif
+}
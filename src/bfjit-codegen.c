@@ -1,30 +1,103 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "bfjit.h"
 #include "bfjit-bitops.h"
 #include "bfjit-codegen.h"
+#include "bfjit-cpu.h"
 #include "bfjit-memory.h"
 #include "bfjit-runtime.h"
 
 typedef struct {
-    size_t jmp;
+    size_t jmp;         // forward jump past the loop, if it has one
+    size_t head;
     int begin;
+    int cached;
 } loop_data;
 
+// jump or padding whose size is chosen once all code is encoded, see enc_relax
+typedef struct {
+    size_t pos;             // offset as encoded
+    size_t target;          // jumps: offset jumped to
+    size_t target_items;    // jumps: number of items before the target, found by enc_relax
+    ptrdiff_t shift;        // how far code after the item moves when relaxed
+    unsigned char op;       // jumps: opcode of the rel8 form, zero for padding
+    unsigned char size;     // as encoded, jumps in the rel32 form and padding with max_pad bytes
+    unsigned char relaxed;  // size after relaxation
+    unsigned char max_pad;  // padding: most bytes it may take
+} bf_layout_item;
+
+// cell kept in a register for the whole body of a loop, every op that
+// addresses a cell other than the current one modifies it, so cached
+// cells are always written back
+typedef struct {
+    int32_t off;
+    uint8_t reg;
+} bf_cached_cell;
+
+// caller-saved registers available for caching cells, rax is used as scratch
+#ifdef _WIN32
+static const uint8_t bf_cell_regs[] = {1, 2, 8, 9, 10, 11};                    // rcx, rdx, r8 - r11
+#else
+static const uint8_t bf_cell_regs[] = {1, 2, 6, 7, 8, 9, 10, 11};              // rcx, rdx, rsi, rdi, r8 - r11
+#endif
+
+#define BF_CELL_REGS_COUNT (sizeof(bf_cell_regs) / sizeof(bf_cell_regs[0]))
+
+// longest constant output written with immediate stores
+#define BF_INLINE_WRITE_MAX 16
+
+// code is written to a reserved range that is committed as it grows, so it
+// never moves and becomes executable in place, rel32 jumps don't reach further
+#define BF_CODE_RESERVE_SIZE ((size_t)1 << 31)
+#define BF_CODE_COMMIT_SIZE ((size_t)64 * 1024)
+
+// heads of hot loops start a fetch block unless that takes more padding,
+// appended parts keep the alignment their code was encoded with
+#define BF_LOOP_ALIGN 32
+#define BF_LOOP_ALIGN_MAX_PAD 15
+
 struct bf_jit_encoder {
     unsigned char* data;
     size_t size;
     size_t cap;
     int rtc;
     int eof;
+    int avx2;
+    int osr;
+    size_t guard_size;
     loop_data* loops;
     size_t loops_size;
     size_t loops_cap;
     size_t copy_loop_start;
     int need_load;
     int need_store;
+    bf_cached_cell cached[BF_CELL_REGS_COUNT];
+    size_t cached_size;
+    int32_t cached_shift;   // pointer movement since the cells were loaded
+    // code offset the flags of the last arithmetic on bl are valid at, no
+    // other code may jump there
+    size_t flags_end;
+    bf_peephole_stats peephole;
+    // constant data placed after the code, and positions of rip-relative
+    // displacements referring to it
+    unsigned char* rodata;
+    size_t rodata_size;
+    size_t rodata_cap;
+    size_t* rodata_refs;
+    size_t rodata_refs_size;
+    size_t rodata_refs_cap;
+    // positions of rel32 displacements of failed bounds checks, the calls
+    // they jump to are placed after the code to keep it out of loops
+    size_t* cold_refs;
+    size_t cold_refs_size;
+    size_t cold_refs_cap;
+    // in code order, kept after the code is finished for bf_jit_encoder_relocate
+    bf_layout_item* layout;
+    size_t layout_size;
+    size_t layout_cap;
 };
 
 bf_jit_encoder* bf_jit_encoder_new(int rtc, int eof)
@@ -35,9 +108,29 @@ bf_jit_encoder* bf_jit_encoder_new(int rtc, int eof)
     enc->cap = 0;
     enc->rtc = rtc;
     enc->eof = eof;
+    enc->avx2 = bf_cpu_has_avx2();
+    enc->osr = 0;
+    enc->guard_size = BF_GUARD_MIN_SIZE;
     enc->loops = NULL;
     enc->loops_size = 0;
     enc->loops_cap = 0;
+    enc->cached_size = 0;
+    enc->cached_shift = 0;
+    enc->flags_end = SIZE_MAX;
+    enc->peephole.flag_tests = 0;
+    enc->peephole.bytes = 0;
+    enc->rodata = NULL;
+    enc->rodata_size = 0;
+    enc->rodata_cap = 0;
+    enc->rodata_refs = NULL;
+    enc->rodata_refs_size = 0;
+    enc->rodata_refs_cap = 0;
+    enc->cold_refs = NULL;
+    enc->cold_refs_size = 0;
+    enc->cold_refs_cap = 0;
+    enc->layout = NULL;
+    enc->layout_size = 0;
+    enc->layout_cap = 0;
     return enc;
 }
 
@@ -46,7 +139,12 @@ void bf_jit_encoder_free(bf_jit_encoder* enc)
     if (enc)
     {
         bf_free(enc->loops);
-        bf_free(enc->data);
+        bf_free(enc->rodata);
+        bf_free(enc->rodata_refs);
+        bf_free(enc->cold_refs);
+        bf_free(enc->layout);
+        if (enc->data)
+            bf_virtual_free(enc->data, BF_CODE_RESERVE_SIZE);
         bf_free(enc);
     }
 }
@@ -55,10 +153,15 @@ static void enc_ensure_cap(bf_jit_encoder* enc, size_t extra_cap)
 {
     if (enc->cap < enc->size + extra_cap)
     {
-        enc->cap = (enc->cap == 0) ? 2048 : enc->cap * 2;
-        if (enc->cap < extra_cap + enc->size)
-            enc->cap = extra_cap + enc->size;
-        enc->data = bf_realloc(enc->data, enc->cap);
+        if (!enc->data)
+            enc->data = bf_virtual_reserve(BF_CODE_RESERVE_SIZE);
+        size_t cap = (enc->cap == 0) ? BF_CODE_COMMIT_SIZE : enc->cap * 2;
+        if (cap < extra_cap + enc->size)
+            cap = (extra_cap + enc->size + BF_CODE_COMMIT_SIZE - 1) & ~(BF_CODE_COMMIT_SIZE - 1);
+        if (cap > BF_CODE_RESERVE_SIZE)
+            bf_error("code too big");
+        bf_virtual_commit(enc->data + enc->cap, cap - enc->cap);
+        enc->cap = cap;
     }
 }
 
@@ -111,70 +214,495 @@ static void enc_replace_int(bf_jit_encoder* enc, int i, size_t off)
         enc->data[off++] = *iter++;
 }
 
-static void enc_write_ptr(bf_jit_encoder* enc, void* p)
+static void bf_write_nops(unsigned char* dst, size_t size)
 {
-    enc_ensure_cap(enc, sizeof(p));
-    unsigned char* iter = (unsigned char*)&p;
-    unsigned char* end = iter + sizeof(p);
-    while (iter != end)
-        enc->data[enc->size++] = *iter++;
+    // each of them decodes as a single instruction
+    static const unsigned char nops[9][9] = {
+        {0x90},                                                     // nop
+        {0x66, 0x90},                                               // xchg ax, ax
+        {0x0F, 0x1F, 0x00},                                         // nop  dword ptr [rax]
+        {0x0F, 0x1F, 0x40, 0x00},                                   // nop  dword ptr [rax+0]
+        {0x0F, 0x1F, 0x44, 0x00, 0x00},                             // nop  dword ptr [rax+rax+0]
+        {0x66, 0x0F, 0x1F, 0x44, 0x00, 0x00},                       // nop  word ptr [rax+rax+0]
+        {0x0F, 0x1F, 0x80, 0x00, 0x00, 0x00, 0x00},                 // nop  dword ptr [rax+0]
+        {0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},           // nop  dword ptr [rax+rax+0]
+        {0x66, 0x0F, 0x1F, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00},     // nop  word ptr [rax+rax+0]
+    };
+    while (size != 0)
+    {
+        size_t n = size < 9 ? size : 9;
+        memcpy(dst, nops[n - 1], n);
+        dst += n;
+        size -= n;
+    }
 }
 
-void bf_jit_encoder_init(bf_jit_encoder* enc)
+// returns the size of padding at 'pos' up to the next multiple of BF_LOOP_ALIGN,
+// zero if it would take more than 'max_pad' bytes
+static size_t bf_pad_size(size_t pos, size_t max_pad)
+{
+    size_t pad = (0 - pos) & (BF_LOOP_ALIGN - 1);
+    return (pad <= max_pad) ? pad : 0;
+}
+
+static size_t enc_push_layout(bf_jit_encoder* enc, const bf_layout_item* item)
+{
+    if (enc->layout_size == enc->layout_cap)
+    {
+        enc->layout_cap = (enc->layout_cap == 0) ? 256 : (enc->layout_cap * 2);
+        enc->layout = bf_realloc(enc->layout, enc->layout_cap * sizeof(bf_layout_item));
+    }
+    enc->layout[enc->layout_size] = *item;
+    return enc->layout_size++;
+}
+
+// padding takes all bytes it may until it is chosen again for the final
+// offsets, so that relaxing never makes code grow
+static void enc_align(bf_jit_encoder* enc, size_t max_pad)
+{
+    bf_layout_item item;
+    item.pos = enc->size;
+    item.target = 0;
+    item.target_items = 0;
+    item.shift = 0;
+    item.op = 0;
+    item.size = (unsigned char)max_pad;
+    item.relaxed = item.size;
+    item.max_pad = (unsigned char)max_pad;
+    enc_push_layout(enc, &item);
+    enc_ensure_cap(enc, item.size);
+    bf_write_nops(enc->data + enc->size, item.size);
+    enc->size += item.size;
+}
+
+static void enc_reserve_rodata(bf_jit_encoder* enc, size_t size)
+{
+    if (enc->rodata_size + size > enc->rodata_cap)
+    {
+        enc->rodata_cap = (enc->rodata_cap == 0) ? 1024 : (enc->rodata_cap * 2);
+        if (enc->rodata_cap < enc->rodata_size + size)
+            enc->rodata_cap = enc->rodata_size + size;
+        enc->rodata = bf_realloc(enc->rodata, enc->rodata_cap);
+    }
+}
+
+static void enc_add_rodata_ref(bf_jit_encoder* enc, size_t pos)
+{
+    if (enc->rodata_refs_size == enc->rodata_refs_cap)
+    {
+        enc->rodata_refs_cap = (enc->rodata_refs_cap == 0) ? 64 : (enc->rodata_refs_cap * 2);
+        enc->rodata_refs = bf_realloc(enc->rodata_refs, enc->rodata_refs_cap * sizeof(size_t));
+    }
+    enc->rodata_refs[enc->rodata_refs_size++] = pos;
+}
+
+// writes a rip-relative displacement of 'size' bytes of constant data,
+// which is fixed up once the final size of the code is known
+static void enc_write_rodata_ref(bf_jit_encoder* enc, const unsigned char* data, size_t size)
+{
+    enc_reserve_rodata(enc, size);
+    enc_add_rodata_ref(enc, enc->size);
+    enc_write_int(enc, (int)enc->rodata_size);
+    memcpy(enc->rodata + enc->rodata_size, data, size);
+    enc->rodata_size += size;
+}
+
+static void enc_add_cold_ref(bf_jit_encoder* enc, size_t pos)
+{
+    if (enc->cold_refs_size == enc->cold_refs_cap)
+    {
+        enc->cold_refs_cap = (enc->cold_refs_cap == 0) ? 64 : (enc->cold_refs_cap * 2);
+        enc->cold_refs = bf_realloc(enc->cold_refs, enc->cold_refs_cap * sizeof(size_t));
+    }
+    enc->cold_refs[enc->cold_refs_size++] = pos;
+}
+
+static void enc_finish_rodata(bf_jit_encoder* enc)
+{
+    if (enc->rodata_size == 0)
+        return;
+
+    size_t base = enc->size;
+    enc_ensure_cap(enc, enc->rodata_size);
+    memcpy(enc->data + base, enc->rodata, enc->rodata_size);
+    enc->size += enc->rodata_size;
+
+    for (size_t i = 0; i != enc->rodata_refs_size; ++i)
+    {
+        size_t pos = enc->rodata_refs[i];
+        int off;
+        memcpy(&off, enc->data + pos, sizeof(off));
+        ptrdiff_t disp = (ptrdiff_t)(base + (size_t)off) - (ptrdiff_t)(pos + 4);
+        if (disp > INT32_MAX)
+            bf_error("code too big");
+        enc_replace_int(enc, (int)disp, pos);
+    }
+    enc->rodata_size = 0;
+    enc->rodata_refs_size = 0;
+}
+
+// padding at 'pos' precedes the code there, so that labels taken where it
+// starts, before or after it was encoded, are placed after it
+static int bf_layout_before(const bf_layout_item* item, size_t pos)
+{
+    return item->pos < pos || (item->pos == pos && item->op == 0);
+}
+
+// number of layout items before code at 'pos'
+static size_t bf_layout_count(const bf_layout_item* items, size_t size, size_t pos)
+{
+    size_t lo = 0;
+    size_t hi = size;
+    while (lo != hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (bf_layout_before(&items[mid], pos))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// offset of code at 'pos' after the 'count' layout items before it are relaxed
+static size_t bf_layout_relocate(const bf_layout_item* items, size_t count, size_t pos)
+{
+    if (count == 0)
+        return pos;
+    const bf_layout_item* last = &items[count - 1];
+    // labels taken before the padding was encoded
+    if (pos < last->pos + last->size)
+        pos = last->pos + last->size;
+    return (size_t)((ptrdiff_t)pos + last->shift);
+}
+
+// forward jumps are identified by their layout item, labels of backward ones by their offset
+typedef size_t bf_jumpdata;
+
+// 'op' is the opcode of the rel8 form, jmp or any jcc, the rel32 form is
+// written until the jump is relaxed
+static size_t enc_jmp(bf_jit_encoder* enc, unsigned char op, size_t target)
+{
+    bf_layout_item item;
+    item.pos = enc->size;
+    item.target = target;
+    item.target_items = 0;
+    item.shift = 0;
+    item.op = op;
+    item.max_pad = 0;
+    if (op == 0xEB)
+    {
+        enc_write_byte(enc, 0xE9);
+    }
+    else
+    {
+        assert(0x70 <= op && op <= 0x7F);
+        enc_write_byte2(enc, 0x0F, (unsigned char)(op + 0x10));
+    }
+    enc_write_int(enc, 0);
+    item.size = (unsigned char)(enc->size - item.pos);
+    item.relaxed = item.size;
+    return enc_push_layout(enc, &item);
+}
+
+static bf_jumpdata enc_jmp_helper_forward_start(bf_jit_encoder* enc, unsigned char op)
+{
+    return enc_jmp(enc, op, SIZE_MAX);
+}
+
+static void enc_jmp_helper_forward_finish(bf_jit_encoder* enc, bf_jumpdata jump)
+{
+    enc->flags_end = SIZE_MAX;
+    enc->layout[jump].target = enc->size;
+}
+
+static bf_jumpdata enc_jmp_helper_backward_start(bf_jit_encoder* enc)
+{
+    enc->flags_end = SIZE_MAX;
+    return enc->size;
+}
+
+static void enc_jmp_helper_backward_finish(bf_jit_encoder* enc, unsigned char op, bf_jumpdata label)
+{
+    enc_jmp(enc, op, label);
+}
+
+// sizes padding for where the code moved and sums up how far the items move it
+static void bf_layout_place(bf_layout_item* items, size_t size)
+{
+    ptrdiff_t shift = 0;
+    for (size_t i = 0; i != size; ++i)
+    {
+        bf_layout_item* item = &items[i];
+        if (item->op == 0)
+            item->relaxed = (unsigned char)bf_pad_size((size_t)((ptrdiff_t)item->pos + shift), item->max_pad);
+        shift += (ptrdiff_t)item->relaxed - (ptrdiff_t)item->size;
+        item->shift = shift;
+    }
+}
+
+// displacement of the relaxed jump at 'index'
+static ptrdiff_t bf_layout_disp(const bf_layout_item* items, size_t index)
+{
+    const bf_layout_item* jump = &items[index];
+    size_t pos = bf_layout_relocate(items, index, jump->pos);
+    return (ptrdiff_t)bf_layout_relocate(items, jump->target_items, jump->target) - (ptrdiff_t)(pos + jump->relaxed);
+}
+
+static void enc_relax(bf_jit_encoder* enc)
+{
+    /*  Jumps start in the rel8 form and those that don't reach their target
+     *  are made rel32 until all of them do. Jumps only grow, so it ends,
+     *  and padding is chosen again on each step for where the code moved.
+     *  No item ends up longer than it was encoded, so the code is compacted
+     *  in place from front to back.
+     */
+    bf_layout_item* items = enc->layout;
+    size_t size = enc->layout_size;
+    for (size_t i = 0; i != size; ++i)
+    {
+        if (items[i].op == 0)
+            continue;
+        assert(items[i].target != SIZE_MAX);
+        // same rule as for all other labels, padding encoded at a forward
+        // target after the jump was finished precedes it too
+        items[i].target_items = bf_layout_count(items, size, items[i].target);
+        items[i].relaxed = 2;
+    }
+    int changed = 1;
+    while (changed)
+    {
+        changed = 0;
+        bf_layout_place(items, size);
+        for (size_t i = 0; i != size; ++i)
+        {
+            bf_layout_item* item = &items[i];
+            if (item->op == 0 || item->relaxed != 2)
+                continue;
+            ptrdiff_t disp = bf_layout_disp(items, i);
+            if (disp < -128 || disp > 127)
+            {
+                item->relaxed = item->size;
+                changed = 1;
+            }
+        }
+    }
+
+    unsigned char* code = enc->data;
+    size_t from = 0;
+    size_t to = 0;
+    for (size_t i = 0; i != size; ++i)
+    {
+        const bf_layout_item* item = &items[i];
+        assert(item->relaxed <= item->size);
+        memmove(code + to, code + from, item->pos - from);
+        to += item->pos - from;
+        from = item->pos + item->size;
+        if (item->op == 0)
+        {
+            bf_write_nops(code + to, item->relaxed);
+        }
+        else
+        {
+            int disp = (int)bf_layout_disp(items, i);
+            if (item->relaxed == 2)
+            {
+                code[to] = item->op;
+                code[to + 1] = (unsigned char)disp;
+            }
+            else
+            {
+                memmove(code + to, code + item->pos, item->size - 4);
+                memcpy(code + to + item->size - 4, &disp, 4);
+            }
+        }
+        to += item->relaxed;
+    }
+    memmove(code + to, code + from, enc->size - from);
+    enc->size = to + (enc->size - from);
+
+    for (size_t i = 0; i != enc->cold_refs_size; ++i)
+        enc->cold_refs[i] = bf_jit_encoder_relocate(enc, enc->cold_refs[i]);
+    for (size_t i = 0; i != enc->rodata_refs_size; ++i)
+        enc->rodata_refs[i] = bf_jit_encoder_relocate(enc, enc->rodata_refs[i]);
+}
+
+static void enc_ctx_store_output(bf_jit_encoder* enc)
+{
+    enc_write_byte4(enc, 0x4D, 0x89, 0x7C, 0x24);
+    enc_write_byte(enc, (unsigned char)offsetof(bf_runtime_context, output_cur)); // mov  qword ptr [r12+output_cur], r15
+}
+
+static void enc_ctx_load_output(bf_jit_encoder* enc)
+{
+    enc_write_byte4(enc, 0x4D, 0x8B, 0x7C, 0x24);
+    enc_write_byte(enc, (unsigned char)offsetof(bf_runtime_context, output_cur)); // mov  r15, qword ptr [r12+output_cur]
+}
+
+static void enc_call_runtime(bf_jit_encoder* enc, size_t function)
+{
+    // runtime functions take context as the first argument and may flush the output buffer
+    enc_ctx_store_output(enc);
+#ifdef _WIN32
+    enc_write_byte3(enc, 0x4C, 0x89, 0xE1);                     // mov  rcx, r12
+#else
+    enc_write_byte3(enc, 0x4C, 0x89, 0xE7);                     // mov  rdi, r12
+#endif
+    enc_write_byte4(enc, 0x41, 0xFF, 0x54, 0x24);
+    enc_write_byte(enc, (unsigned char)function);               // call qword ptr [r12+<function>]
+    enc_ctx_load_output(enc);
+}
+
+// out_of_bounds(ctx, ptr, pc) for every failed check, which leaves the cell
+// it checked in rax, each of them loads 'pc' pointing into the check and
+// jumps to a shared call
+static void enc_finish_cold(bf_jit_encoder* enc)
+{
+    if (enc->cold_refs_size == 0)
+        return;
+
+    size_t call = enc->size;
+#ifdef _WIN32
+    enc_write_byte3(enc, 0x48, 0x89, 0xC2);                     // mov  rdx, rax
+#else
+    enc_write_byte3(enc, 0x48, 0x89, 0xC6);                     // mov  rsi, rax
+#endif
+    enc_call_runtime(enc, offsetof(bf_runtime_context, out_of_bounds));
+
+    for (size_t i = 0; i != enc->cold_refs_size; ++i)
+    {
+        size_t pos = enc->cold_refs[i];
+        enc_replace_int(enc, (int)(enc->size - (pos + 4)), pos);
+#ifdef _WIN32
+        enc_write_byte3(enc, 0x4C, 0x8D, 0x05);
+        enc_write_int(enc, (int)(pos - (enc->size + 4)));       // lea  r8, [rip+<check>]
+#else
+        enc_write_byte3(enc, 0x48, 0x8D, 0x15);
+        enc_write_int(enc, (int)(pos - (enc->size + 4)));       // lea  rdx, [rip+<check>]
+#endif
+        ptrdiff_t where = (ptrdiff_t)call - (ptrdiff_t)(enc->size + 2);
+        if (where >= -128)
+        {
+            enc_write_byte2(enc, 0xEB, (unsigned char)where);   // jmp  <call>
+        }
+        else
+        {
+            enc_write_byte(enc, 0xE9);
+            enc_write_int(enc, (int)(where - 3));               // jmp  <call>
+        }
+    }
+    enc->cold_refs_size = 0;
+}
+
+void bf_jit_encoder_set_guard_size(bf_jit_encoder* enc, size_t size)
+{
+    assert(BF_GUARD_MIN_SIZE <= size && size <= BF_GUARD_MAX_SIZE);
+    enc->guard_size = size;
+}
+
+void bf_jit_encoder_set_avx2(bf_jit_encoder* enc, int avx2)
+{
+    enc->avx2 = avx2 && bf_cpu_has_avx2();
+}
+
+void bf_jit_encoder_set_osr(bf_jit_encoder* enc, int osr)
+{
+    enc->osr = osr;
+}
+
+// shared by the main entry and the osr stub, so that both leave the stack
+// in the state the epilogue expects
+static void enc_prologue(bf_jit_encoder* enc)
 {
     // rbp       - main pointer
     // r13 & r14 - beginning and end of program memory, used for bounds checking
-    // r12       - address of error function
-    // r15       - address of output function
+    // r12       - runtime context
+    // r15       - current position in output buffer
     // bl        - cached value of [rbp]
 
+    enc_write_byte2(enc, 0x41, 0x54);                           // push r12
     if (enc->rtc)
     {
-        enc_write_byte2(enc, 0x41, 0x54);                       // push r12
         enc_write_byte2(enc, 0x41, 0x55);                       // push r13
         enc_write_byte2(enc, 0x41, 0x56);                       // push r14
-        enc_write_byte2(enc, 0x49, 0xBC);
-        enc_write_ptr(enc, (void*)&bf_runtime_out_of_bounds);   // mov  r12, qword ptr out_of_bounds
-#ifdef _WIN32
-        enc_write_byte3(enc, 0x49, 0x89, 0xCD);                 // mov  r13, rcx
-        enc_write_byte3(enc, 0x49, 0x89, 0xD6);                 // mov  r14, rdx
-#else
-        enc_write_byte3(enc, 0x49, 0x89, 0xFD);                 // mov  r13, rdi
-        enc_write_byte3(enc, 0x49, 0x89, 0xF6);                 // mov  r14, rsi
-#endif
     }
     enc_write_byte2(enc, 0x41, 0x57);                           // push r15
-    enc_write_byte2(enc, 0x49, 0xBF);
-    enc_write_ptr(enc, (void*)&bf_runtime_write_char);          // mov  r15, qword ptr write_char
     enc_write_byte(enc, 0x53);                                  // push rbx
     enc_write_byte2(enc, 0x31, 0xDB);                           // xor  ebx, ebx
     enc_write_byte(enc, 0x55);                                  // push rbp
 #ifdef _WIN32
+    enc_write_byte3(enc, 0x49, 0x89, 0xD4);                     // mov  r12, rdx
     enc_write_byte3(enc, 0x48, 0x89, 0xCD);                     // mov  rbp, rcx
-    if (!enc->rtc)
-        enc_write_byte4(enc, 0x48, 0x83, 0xEC, 0x20);           // sub  rsp, 32
-    else
-        enc_write_byte4(enc, 0x48, 0x83, 0xEC, 0x28);           // sub  rsp, 40
+    enc_write_byte4(enc, 0x48, 0x83, 0xEC, 0x28);               // sub  rsp, 40
 #else
+    enc_write_byte3(enc, 0x49, 0x89, 0xF4);                     // mov  r12, rsi
     enc_write_byte3(enc, 0x48, 0x89, 0xFD);                     // mov  rbp, rdi
-    if (enc->rtc)
-        enc_write_byte4(enc, 0x48, 0x83, 0xEC, 0x08);           // sub  rsp, 8
+    enc_write_byte4(enc, 0x48, 0x83, 0xEC, 0x08);               // sub  rsp, 8
 #endif
+    if (enc->rtc)
+    {
+        enc_write_byte4(enc, 0x4D, 0x8B, 0x6C, 0x24);
+        enc_write_byte(enc, (unsigned char)offsetof(bf_runtime_context, tape_begin)); // mov  r13, qword ptr [r12+tape_begin]
+        enc_write_byte4(enc, 0x4D, 0x8B, 0x74, 0x24);
+        enc_write_byte(enc, (unsigned char)offsetof(bf_runtime_context, tape_end)); // mov  r14, qword ptr [r12+tape_end]
+    }
+    enc_ctx_load_output(enc);
+}
 
+void bf_jit_encoder_init(bf_jit_encoder* enc)
+{
+    enc->layout_size = 0;
+    enc_prologue(enc);
     enc->need_load = 0;
     enc->need_store = 0;
 }
 
+size_t bf_jit_encoder_offset(bf_jit_encoder* enc)
+{
+    return enc->size;
+}
+
+size_t bf_jit_encoder_relocate(const bf_jit_encoder* enc, size_t offset)
+{
+    return bf_layout_relocate(enc->layout, bf_layout_count(enc->layout, enc->layout_size, offset), offset);
+}
+
+size_t bf_jit_encoder_relocate_next(const bf_jit_encoder* enc, size_t offset, size_t* cursor)
+{
+    const bf_layout_item* items = enc->layout;
+    size_t count = *cursor;
+    while (count != enc->layout_size && bf_layout_before(&items[count], offset))
+        count += 1;
+    *cursor = count;
+    return bf_layout_relocate(items, count, offset);
+}
+
+size_t bf_jit_encode_osr_entry(bf_jit_encoder* enc)
+{
+    assert(enc->osr && enc->cached_size == 0);
+    enc->flags_end = SIZE_MAX;
+    return enc->size;
+}
+
+// void osr(unsigned char* ptr, bf_runtime_context* ctx, const void* entry)
+static void enc_osr_stub(bf_jit_encoder* enc)
+{
+    enc_prologue(enc);
+    enc_write_byte3(enc, 0x8A, 0x5D, 0x00);                     // mov  bl, byte ptr [rbp]
+#ifdef _WIN32
+    enc_write_byte3(enc, 0x41, 0xFF, 0xE0);                     // jmp  r8
+#else
+    enc_write_byte2(enc, 0xFF, 0xE2);                           // jmp  rdx
+#endif
+}
+
 bf_compiled_code bf_jit_encoder_finish(bf_jit_encoder* enc)
 {
+    enc_ctx_store_output(enc);
 #ifdef _WIN32
-    if (!enc->rtc)
-        enc_write_byte4(enc, 0x48, 0x83, 0xC4, 0x20);           // add  rsp, 32
-    else
-        enc_write_byte4(enc, 0x48, 0x83, 0xC4, 0x28);           // add  rsp, 40
+    enc_write_byte4(enc, 0x48, 0x83, 0xC4, 0x28);               // add  rsp, 40
 #else
-    if (enc->rtc)
-        enc_write_byte4(enc, 0x48, 0x83, 0xC4, 0x08);           // add  rsp, 8
+    enc_write_byte4(enc, 0x48, 0x83, 0xC4, 0x08);               // add  rsp, 8
 #endif
     enc_write_byte(enc, 0x5D);                                  // pop  rbp
     enc_write_byte(enc, 0x5B);                                  // pop  rbx
@@ -183,13 +711,25 @@ bf_compiled_code bf_jit_encoder_finish(bf_jit_encoder* enc)
     {
         enc_write_byte2(enc, 0x41, 0x5E);                       // pop  r14
         enc_write_byte2(enc, 0x41, 0x5D);                       // pop  r13
-        enc_write_byte2(enc, 0x41, 0x5C);                       // pop  r12
     }
+    enc_write_byte2(enc, 0x41, 0x5C);                           // pop  r12
     enc_write_byte(enc, 0xC3);                                  // ret
+    enc_relax(enc);
+    size_t osr_entry = 0;
+    if (enc->osr)
+    {
+        osr_entry = enc->size;
+        enc_osr_stub(enc);
+    }
+    enc_finish_cold(enc);
+    enc_finish_rodata(enc);
 
     bf_compiled_code code;
     code.data = enc->data;
     code.size = enc->size;
+    code.osr_entry = osr_entry;
+    code.guard_size = (enc->rtc == BF_CHECK_GUARD) ? enc->guard_size : 0;
+    code.mapped_size = 0;
     enc->data = NULL;
     enc->size = 0;
     enc->cap = 0;
@@ -197,12 +737,25 @@ bf_compiled_code bf_jit_encoder_finish(bf_jit_encoder* enc)
     return code;
 }
 
-void bf_jit_encode_check(bf_jit_encoder* enc, int32_t x)
+void bf_compiled_code_free(bf_compiled_code* code)
 {
-    assert(x != 0);
-    if (!enc->rtc)
-        return;
+    if (code->data)
+        bf_virtual_free(code->data, BF_CODE_RESERVE_SIZE);
+    code->data = NULL;
+}
 
+void bf_jit_encode_count(bf_jit_encoder* enc, uint32_t counter)
+{
+    assert(counter <= INT32_MAX / 8);
+    enc_write_byte4(enc, 0x49, 0x8B, 0x44, 0x24);
+    enc_write_byte(enc, (unsigned char)offsetof(bf_runtime_context, counters)); // mov  rax, qword ptr [r12+counters]
+    enc_write_byte3(enc, 0x48, 0xFF, 0x80);
+    enc_write_int(enc, (int)(counter * 8));                                     // inc  qword ptr [rax+<counter * 8>]
+}
+
+// checks cell[x] against the sides of the tape asked for
+static void enc_check_impl(bf_jit_encoder* enc, int32_t x, int below, int above)
+{
     if (-128 <= x && x <= 127)
     {
         enc_write_byte4(enc, 0x48, 0x8D, 0x45, (unsigned char)x);   // lea  rax, [rbp+x]
@@ -213,22 +766,47 @@ void bf_jit_encode_check(bf_jit_encoder* enc, int32_t x)
         enc_write_int(enc, x);                                      // lea  rax, [rbp+x]
     }
 
-    if (x < 0)
+    if (below)
     {
         enc_write_byte3(enc, 0x4C, 0x39, 0xE8);                     // cmp  rax, r13
-        enc_write_byte2(enc, 0x7D, 0x03);                           // jge  3
+        enc_write_byte2(enc, 0x0F, 0x8C);                           // jl   <fail>
+        enc_add_cold_ref(enc, enc->size);
+        enc_write_int(enc, 0);
     }
-    else
+    if (above)
     {
         enc_write_byte3(enc, 0x4C, 0x39, 0xF0);                     // cmp  rax, r14
-        enc_write_byte2(enc, 0x7C, 0x03);                           // jl   3
+        enc_write_byte2(enc, 0x0F, 0x8D);                           // jge  <fail>
+        enc_add_cold_ref(enc, enc->size);
+        enc_write_int(enc, 0);
     }
-    enc_write_byte3(enc, 0x41, 0xFF, 0xD4);                         // call r12
+}
+
+void bf_jit_encode_check(bf_jit_encoder* enc, int32_t x)
+{
+    assert(x != 0);
+    if (!enc->rtc)
+        return;
+    // accesses that can't skip over the upper guard pages fault on their
+    // own, the lower ones may be preceded by the rest of the last tape page
+    if (enc->rtc == BF_CHECK_GUARD && x > 0 && (size_t)x < enc->guard_size)
+        return;
+    enc_check_impl(enc, x, x < 0, x > 0);
+}
+
+void bf_jit_encode_probe(bf_jit_encoder* enc, int32_t x)
+{
+    // nothing accesses the cell, so guard pages don't catch it either
+    if (enc->rtc)
+        enc_check_impl(enc, x, 1, 1);
 }
 
 static void enc_store_impl(bf_jit_encoder* enc)
 {
+    int flags = enc->flags_end == enc->size;
     enc_write_byte3(enc, 0x88, 0x5D, 0x00);                                 // mov  byte ptr [rbp], bl
+    if (flags)
+        enc->flags_end = enc->size;
 }
 
 static void enc_load_impl(bf_jit_encoder* enc)
@@ -256,6 +834,140 @@ static void enc_store(bf_jit_encoder* enc)
     }
 }
 
+bf_jit_encoder* bf_jit_encoder_new_part(const bf_jit_encoder* enc)
+{
+    bf_jit_encoder* part = bf_jit_encoder_new(enc->rtc, enc->eof);
+    part->avx2 = enc->avx2;
+    part->osr = enc->osr;
+    part->guard_size = enc->guard_size;
+    // what bl holds when the part starts isn't known
+    part->need_load = 1;
+    part->need_store = 0;
+    return part;
+}
+
+size_t bf_jit_encoder_append_part(bf_jit_encoder* enc, bf_jit_encoder* part)
+{
+    assert(enc->loops_size == 0 && part->loops_size == 0 && part->cached_size == 0);
+    enc_store(enc);
+    enc_store(part);
+
+    enc_align(enc, BF_LOOP_ALIGN - 1);
+    size_t base = enc->size;
+    enc_ensure_cap(enc, part->size);
+    memcpy(enc->data + base, part->data, part->size);
+    enc->size += part->size;
+
+    for (size_t i = 0; i != part->cold_refs_size; ++i)
+        enc_add_cold_ref(enc, base + part->cold_refs[i]);
+    for (size_t i = 0; i != part->layout_size; ++i)
+    {
+        bf_layout_item item = part->layout[i];
+        item.pos += base;
+        item.target += base;
+        enc_push_layout(enc, &item);
+    }
+
+    // constant data of the part follows the data of 'enc'
+    for (size_t i = 0; i != part->rodata_refs_size; ++i)
+    {
+        size_t pos = base + part->rodata_refs[i];
+        int off;
+        memcpy(&off, enc->data + pos, sizeof(off));
+        enc_replace_int(enc, (int)(enc->rodata_size + (size_t)off), pos);
+        enc_add_rodata_ref(enc, pos);
+    }
+    enc_reserve_rodata(enc, part->rodata_size);
+    if (part->rodata_size != 0)
+        memcpy(enc->rodata + enc->rodata_size, part->rodata, part->rodata_size);
+    enc->rodata_size += part->rodata_size;
+
+    enc->need_load = 1;
+    enc->flags_end = SIZE_MAX;
+    enc->peephole.flag_tests += part->peephole.flag_tests;
+    enc->peephole.bytes += part->peephole.bytes;
+    return base;
+}
+
+const bf_peephole_stats* bf_jit_encoder_peephole(const bf_jit_encoder* enc)
+{
+    return &enc->peephole;
+}
+
+// add, sub, inc, dec and xor of bl leave the flags of a test behind
+static void enc_flags_set(bf_jit_encoder* enc)
+{
+    enc->flags_end = enc->size;
+}
+
+static void enc_test_cell(bf_jit_encoder* enc)
+{
+    if (enc->flags_end == enc->size)
+    {
+        enc->peephole.flag_tests += 1;
+        enc->peephole.bytes += 2;
+        return;
+    }
+    enc_write_byte2(enc, 0x84, 0xDB);                                       // test bl, bl
+    enc_flags_set(enc);
+}
+
+// REX prefix needed to address low byte of 'reg' in the r/m field of ModRM
+static void enc_rex_rm8(bf_jit_encoder* enc, uint8_t reg)
+{
+    if (reg >= 8)
+        enc_write_byte(enc, 0x41);
+    else if (reg >= 4)
+        enc_write_byte(enc, 0x40);
+}
+
+// REX prefix needed to address low byte of 'reg' in the reg field of ModRM
+static void enc_rex_reg8(bf_jit_encoder* enc, uint8_t reg)
+{
+    if (reg >= 8)
+        enc_write_byte(enc, 0x44);
+    else if (reg >= 4)
+        enc_write_byte(enc, 0x40);
+}
+
+// <opcode> with 8-bit 'reg' and byte ptr [rbp+<off>] operands
+static void enc_reg8_rbp(bf_jit_encoder* enc, unsigned char opcode, uint8_t reg, int32_t off)
+{
+    enc_rex_reg8(enc, reg);
+    if (-128 <= off && off <= 127)
+    {
+        enc_write_byte3(enc, opcode, (unsigned char)(0x45 | (reg & 7) << 3), (unsigned char)off);
+    }
+    else
+    {
+        enc_write_byte2(enc, opcode, (unsigned char)(0x85 | (reg & 7) << 3));
+        enc_write_int(enc, off);
+    }
+}
+
+static bf_cached_cell* enc_find_cached(bf_jit_encoder* enc, int32_t off)
+{
+    off += enc->cached_shift;
+    for (size_t i = 0; i != enc->cached_size; ++i)
+        if (enc->cached[i].off == off)
+            return &enc->cached[i];
+    return NULL;
+}
+
+static void enc_load_cached(bf_jit_encoder* enc)
+{
+    for (size_t i = 0; i != enc->cached_size; ++i)
+        enc_reg8_rbp(enc, 0x8A, enc->cached[i].reg, enc->cached[i].off - enc->cached_shift); // mov  <reg>, byte ptr [rbp+<off>]
+}
+
+// registers of cached cells don't survive runtime calls, they are written
+// back before the arguments are set up and loaded again after the call
+static void enc_spill_cached(bf_jit_encoder* enc)
+{
+    for (size_t i = 0; i != enc->cached_size; ++i)
+        enc_reg8_rbp(enc, 0x88, enc->cached[i].reg, enc->cached[i].off - enc->cached_shift); // mov  byte ptr [rbp+<off>], <reg>
+}
+
 static void enc_encode_next_impl(bf_jit_encoder* enc, int32_t count)
 {
     if (count > 0)
@@ -297,7 +1009,15 @@ void bf_jit_encode_next_unsafe(bf_jit_encoder* enc, int32_t count)
     assert(count != 0);
     enc_store(enc);
     enc_encode_next_impl(enc, count);
+    if (enc->cached_size != 0)
+        enc->cached_shift += count;
     enc->need_load = 1;
+    if (enc->rtc == BF_CHECK_GUARD)
+    {
+        // touch the new cell right away, so that the pointer never
+        // moves further than one step into the guard pages
+        enc_load(enc);
+    }
 }
 
 void bf_jit_encode_next(bf_jit_encoder* enc, int32_t count)
@@ -319,6 +1039,7 @@ void bf_jit_encode_add(bf_jit_encoder* enc, int32_t count)
         enc_write_byte3(enc, 0x80, 0xC3, (unsigned char)count);     // add  bl, <count>
     else
         enc_write_byte3(enc, 0x80, 0xEB, (unsigned char)-count);    // sub  bl, <-count>
+    enc_flags_set(enc);
     enc->need_store = 1;
 }
 
@@ -331,8 +1052,11 @@ static void enc_save_loop_start(bf_jit_encoder* enc, int begin)
     }
 
     loop_data l;
-    l.jmp = enc->size;
+    l.jmp = 0;
+    l.head = enc->size;
+    enc->flags_end = SIZE_MAX;
     l.begin = begin;
+    l.cached = 0;
     enc->loops[enc->loops_size++] = l;
 }
 
@@ -340,13 +1064,11 @@ void bf_jit_encode_loop_start(bf_jit_encoder* enc)
 {
     enc_load(enc);
     enc_store(enc);
-    // number of bytes written here must correspond to value
-    // subtracted in bf_jit_pop_started_loop
-    enc_write_byte2(enc, 0x84, 0xDB);                               // test bl, bl
-    enc_write_byte2(enc, 0x0F, 0x84);
-    enc_write_int(enc, 0);                                          // jz   <placeholder>
+    enc_test_cell(enc);
+    bf_jumpdata j = enc_jmp_helper_forward_start(enc, 0x74);        // jz   <loop_end>
 
     enc_save_loop_start(enc, 1);
+    enc->loops[enc->loops_size - 1].jmp = j;
 }
 
 void bf_jit_encode_loop_start_optimized(bf_jit_encoder* enc)
@@ -354,43 +1076,70 @@ void bf_jit_encode_loop_start_optimized(bf_jit_encoder* enc)
     enc_save_loop_start(enc, 0);
 }
 
-void bf_jit_pop_started_loop(bf_jit_encoder* enc)
+void bf_jit_encode_loop_cache_cells(bf_jit_encoder* enc, const int32_t* offs, size_t count)
 {
-    assert(enc->loops_size != 0);
-    if (enc->loops[enc->loops_size - 1].begin)
-        enc->size -= 8;
-    enc->loops_size -= 1;
+    assert(enc->loops_size != 0 && enc->cached_size == 0);
+    loop_data* l = &enc->loops[enc->loops_size - 1];
+    if (count > BF_CELL_REGS_COUNT)
+        count = BF_CELL_REGS_COUNT;
+
+    for (size_t i = 0; i != count; ++i)
+    {
+        assert(offs[i] != 0);
+        bf_cached_cell c;
+        c.off = offs[i];
+        c.reg = bf_cell_regs[i];
+        enc->cached[i] = c;
+    }
+    enc->cached_size = count;
+    enc->cached_shift = 0;
+
+    enc_load_cached(enc);
+    l->cached = count != 0;
 }
 
-size_t bf_jit_current_loop_size(bf_jit_encoder* enc)
+void bf_jit_encode_loop_align(bf_jit_encoder* enc)
+{
+    enc_align(enc, BF_LOOP_ALIGN_MAX_PAD);
+}
+
+void bf_jit_encode_loop_head(bf_jit_encoder* enc)
 {
     assert(enc->loops_size != 0);
-    return enc->size - enc->loops[enc->loops_size - 1].jmp;
+    enc->loops[enc->loops_size - 1].head = enc->size;
+    enc->flags_end = SIZE_MAX;
+}
+
+static void enc_loop_exit(bf_jit_encoder* enc, const loop_data* data)
+{
+    if (data->cached)
+    {
+        assert(enc->cached_shift == 0);
+        enc_spill_cached(enc);
+        enc->cached_size = 0;
+    }
+    if (data->begin)
+    {
+        enc_jmp_helper_forward_finish(enc, data->jmp);
+    }
 }
 
 void bf_jit_encode_loop_end_optimized(bf_jit_encoder* enc)
 {
     assert(enc->loops_size != 0);
     loop_data data = enc->loops[--enc->loops_size];
-    if (data.begin)
-    {
-        size_t l = data.jmp;
-        enc_replace_int(enc, (int)(enc->size - l), l - 4);
-    }
+    enc_loop_exit(enc, &data);
 }
 
 void bf_jit_encode_loop_end(bf_jit_encoder* enc)
 {
     assert(enc->loops_size != 0);
     loop_data data = enc->loops[--enc->loops_size];
-    size_t l = data.jmp;
     enc_load(enc);
     enc_store(enc);
-    enc_write_byte2(enc, 0x84, 0xDB);                                   // test bl, bl
-    enc_write_byte2(enc, 0x0F, 0x85);
-    enc_write_int(enc, (int)(l - 4 - enc->size));                       // jnz  <'[' location>
-    if (data.begin)
-        enc_replace_int(enc, (int)(enc->size - l), l - 4);
+    enc_test_cell(enc);
+    enc_jmp_helper_backward_finish(enc, 0x75, data.head);               // jnz  <'[' location>
+    enc_loop_exit(enc, &data);
 }
 
 int bf_jit_is_in_loop(bf_jit_encoder* enc)
@@ -400,50 +1149,164 @@ int bf_jit_is_in_loop(bf_jit_encoder* enc)
 
 void bf_jit_encode_input(bf_jit_encoder* enc)
 {
+    // eof policy is applied by the runtime when the input buffer runs out
+    size_t refill;
+    int nochange = 0;
     if (enc->eof == 0)
-    {
-        // cell set to 0 on eof
-        enc_write_byte2(enc, 0x48, 0xB8);
-        enc_write_ptr(enc, (void*)&bf_runtime_read_char_eof_zero);      // mov  rax, qword ptr read_char(0)
-    }
+        refill = offsetof(bf_runtime_context, read_char_eof_zero);
     else if (enc->eof == -1)
+        refill = offsetof(bf_runtime_context, read_char_eof_minusone);
+    else
     {
-        // cell set to -1 on eof
-        enc_write_byte2(enc, 0x48, 0xB8);
-        enc_write_ptr(enc, (void*)&bf_runtime_read_char_eof_minusone);  // mov  rax, qword ptr read_char(-1)
+        refill = offsetof(bf_runtime_context, read_char_eof_nochange);
+        nochange = 1;
+        enc_load(enc);
     }
-    else
+
+    enc_write_byte4(enc, 0x49, 0x8B, 0x44, 0x24);
+    enc_write_byte(enc, (unsigned char)offsetof(bf_runtime_context, input_cur));   // mov  rax, qword ptr [r12+input_cur]
+    enc_write_byte4(enc, 0x49, 0x3B, 0x44, 0x24);
+    enc_write_byte(enc, (unsigned char)offsetof(bf_runtime_context, input_end));   // cmp  rax, qword ptr [r12+input_end]
+    bf_jumpdata j1 = enc_jmp_helper_forward_start(enc, 0x73);           // jae  <refill>
+    enc_write_byte2(enc, 0x8A, 0x18);                                   // mov  bl, byte ptr [rax]
+    enc_write_byte3(enc, 0x48, 0xFF, 0xC0);                             // inc  rax
+    enc_write_byte4(enc, 0x49, 0x89, 0x44, 0x24);
+    enc_write_byte(enc, (unsigned char)offsetof(bf_runtime_context, input_cur));   // mov  qword ptr [r12+input_cur], rax
+    bf_jumpdata j2 = enc_jmp_helper_forward_start(enc, 0xEB);           // jmp  <end>
+    enc_jmp_helper_forward_finish(enc, j1);                             // refill:
+    enc_spill_cached(enc);
+    if (nochange)
     {
         // cell unchanged on eof
 #ifdef _WIN32
-        enc_write_byte2(enc, 0x88, 0xD9);                               // mov  cl, bl
+        enc_write_byte3(enc, 0x0F, 0xB6, 0xD3);                         // movzx edx, bl
 #else
-        enc_write_byte3(enc, 0x40, 0x88, 0xDF);                         // mov  dil, bl
+        enc_write_byte3(enc, 0x0F, 0xB6, 0xF3);                         // movzx esi, bl
 #endif
-        enc_write_byte2(enc, 0x48, 0xB8);
-        enc_write_ptr(enc, (void*)&bf_runtime_read_char_eof_nochange);  // mov  rax, qword ptr read_char(no change)
     }
-    enc_write_byte2(enc, 0xFF, 0xD0);                                   // call rax
+    enc_call_runtime(enc, refill);
     enc_write_byte2(enc, 0x88, 0xC3);                                   // mov  bl, al
+    enc_load_cached(enc);
+    enc_jmp_helper_forward_finish(enc, j2);                             // end:
     enc->need_store = 1;
     enc->need_load = 0;
 }
 
 void bf_jit_encode_output(bf_jit_encoder* enc)
 {
+    // output buffer is aligned to its size, so it is full
+    // when the position wraps around to an aligned address
     enc_load(enc);
+    enc_write_byte3(enc, 0x41, 0x88, 0x1F);                             // mov  byte ptr [r15], bl
+    enc_write_byte3(enc, 0x49, 0xFF, 0xC7);                             // inc  r15
+    enc_write_byte3(enc, 0x41, 0xF7, 0xC7);
+    enc_write_int(enc, BF_OUTPUT_BUFFER_SIZE - 1);                      // test r15d, <size - 1>
+    bf_jumpdata j = enc_jmp_helper_forward_start(enc, 0x75);            // jnz  <end>
+    enc_spill_cached(enc);
+    enc_call_runtime(enc, offsetof(bf_runtime_context, flush_output));
+    enc_load_cached(enc);
+    enc_jmp_helper_forward_finish(enc, j);                              // end:
+}
+
+void bf_jit_encode_output_repeat(bf_jit_encoder* enc, int32_t count)
+{
+    assert(count > 0);
+    if (count <= 4)
+    {
+        for (int32_t i = 0; i != count; ++i)
+            bf_jit_encode_output(enc);
+        return;
+    }
+
+    enc_load(enc);
+    enc_spill_cached(enc);
 #ifdef _WIN32
-    enc_write_byte2(enc, 0x88, 0xD9);                                   // mov  cl, bl
+    enc_write_byte3(enc, 0x0F, 0xB6, 0xD3);                             // movzx edx, bl
+    enc_write_byte2(enc, 0x41, 0xB8);
+    enc_write_int(enc, count);                                          // mov  r8d, <count>
 #else
-    enc_write_byte3(enc, 0x40, 0x88, 0xDF);                             // mov  dil, bl
+    enc_write_byte3(enc, 0x0F, 0xB6, 0xF3);                             // movzx esi, bl
+    enc_write_byte(enc, 0xBA);
+    enc_write_int(enc, count);                                          // mov  edx, <count>
 #endif
-    enc_write_byte3(enc, 0x41, 0xFF, 0xD7);                             // call r15
+    enc_call_runtime(enc, offsetof(bf_runtime_context, fill_output));
+    enc_load_cached(enc);
+}
+
+void bf_jit_encode_write(bf_jit_encoder* enc, const unsigned char* data, int32_t size)
+{
+    assert(size > 0);
+    if (size > BF_INLINE_WRITE_MAX)
+    {
+        enc_spill_cached(enc);
+#ifdef _WIN32
+        enc_write_byte3(enc, 0x48, 0x8D, 0x15);
+        enc_write_rodata_ref(enc, data, (size_t)size);                 // lea  rdx, [rip+<data>]
+        enc_write_byte2(enc, 0x41, 0xB8);
+        enc_write_int(enc, size);                                       // mov  r8d, <size>
+#else
+        enc_write_byte3(enc, 0x48, 0x8D, 0x35);
+        enc_write_rodata_ref(enc, data, (size_t)size);                 // lea  rsi, [rip+<data>]
+        enc_write_byte(enc, 0xBA);
+        enc_write_int(enc, size);                                       // mov  edx, <size>
+#endif
+        enc_call_runtime(enc, offsetof(bf_runtime_context, write_output));
+        enc_load_cached(enc);
+        return;
+    }
+
+    // short strings are stored with immediates, the buffer is flushed
+    // first unless it has room for all of them and one more byte
+    enc_write_byte3(enc, 0x44, 0x89, 0xF8);                             // mov  eax, r15d
+    enc_write_byte(enc, 0x25);
+    enc_write_int(enc, BF_OUTPUT_BUFFER_SIZE - 1);                      // and  eax, <size - 1>
+    enc_write_byte(enc, 0x3D);
+    enc_write_int(enc, BF_OUTPUT_BUFFER_SIZE - size);                   // cmp  eax, <buffer size - size>
+    bf_jumpdata j = enc_jmp_helper_forward_start(enc, 0x72);            // jb   <store>
+    enc_spill_cached(enc);
+    enc_call_runtime(enc, offsetof(bf_runtime_context, flush_output));
+    enc_load_cached(enc);
+    enc_jmp_helper_forward_finish(enc, j);                              // store:
+
+    int32_t i = 0;
+    for (; size - i >= 4; i += 4)
+    {
+        int32_t imm;
+        memcpy(&imm, data + i, sizeof(imm));
+        if (i == 0)
+            enc_write_byte3(enc, 0x41, 0xC7, 0x07);
+        else
+            enc_write_byte4(enc, 0x41, 0xC7, 0x47, (unsigned char)i);
+        enc_write_int(enc, imm);                                        // mov  dword ptr [r15+<i>], <imm>
+    }
+    for (; i != size; ++i)
+    {
+        if (i == 0)
+        {
+            enc_write_byte4(enc, 0x41, 0xC6, 0x07, data[i]);            // mov  byte ptr [r15], <imm>
+        }
+        else
+        {
+            enc_write_byte4(enc, 0x41, 0xC6, 0x47, (unsigned char)i);
+            enc_write_byte(enc, data[i]);                               // mov  byte ptr [r15+<i>], <imm>
+        }
+    }
+    enc_write_byte4(enc, 0x49, 0x83, 0xC7, (unsigned char)size);        // add  r15, <size>
 }
 
 void bf_jit_encode_offop_unsafe(bf_jit_encoder* enc, int32_t count, int32_t off)
 {
     assert(count != 0 && off != 0);
-    if (count > 0 && -128 <= off && off <= 127)
+    bf_cached_cell* c = enc_find_cached(enc, off);
+    if (c)
+    {
+        enc_rex_rm8(enc, c->reg);
+        if (count > 0)
+            enc_write_byte3(enc, 0x80, (unsigned char)(0xC0 | (c->reg & 7)), (unsigned char)count); // add  <reg>, <count>
+        else
+            enc_write_byte3(enc, 0x80, (unsigned char)(0xE8 | (c->reg & 7)), (unsigned char)-count); // sub  <reg>, <-count>
+    }
+    else if (count > 0 && -128 <= off && off <= 127)
     {
         enc_write_byte4(enc, 0x80, 0x45,
                         (unsigned char)off,
@@ -472,6 +1335,7 @@ void bf_jit_encode_offop_unsafe(bf_jit_encoder* enc, int32_t count, int32_t off)
 static void enc_clear_cache(bf_jit_encoder* enc)
 {
     enc_write_byte2(enc, 0x31, 0xDB);                                   // xor  ebx, ebx
+    enc_flags_set(enc);
 }
 
 void bf_jit_encode_set(bf_jit_encoder* enc, int32_t val)
@@ -484,40 +1348,69 @@ void bf_jit_encode_set(bf_jit_encoder* enc, int32_t val)
     enc->need_load = 0;
 }
 
-typedef size_t bf_jumpdata;
-
-static bf_jumpdata enc_jmp_helper_forward_start(bf_jit_encoder* enc)
+void bf_jit_encode_set_offset_unsafe(bf_jit_encoder* enc, int32_t val, int32_t off)
 {
-    return enc->size;
+    assert(off != 0);
+    bf_cached_cell* c = enc_find_cached(enc, off);
+    if (c)
+    {
+        enc_rex_rm8(enc, c->reg);
+        enc_write_byte2(enc, (unsigned char)(0xB0 | (c->reg & 7)), (unsigned char)val); // mov  <reg>, <val>
+    }
+    else if (-128 <= off && off <= 127)
+    {
+        enc_write_byte4(enc, 0xC6, 0x45,
+                        (unsigned char)off,
+                        (unsigned char)val);                            // mov  byte ptr [rbp+<off>], <val>
+    }
+    else
+    {
+        enc_write_byte2(enc, 0xC6, 0x85);
+        enc_write_int(enc, off);
+        enc_write_byte(enc, (unsigned char)val);                        // mov  byte ptr [rbp+<off>], <val>
+    }
 }
 
-static void enc_jmp_helper_forward_finish(bf_jit_encoder* enc, bf_jumpdata pos)
+void bf_jit_encode_init(bf_jit_encoder* enc, const unsigned char* data, int32_t size)
 {
-    ptrdiff_t where = enc->size - pos;
-    if (where > 127)
-        bf_error("jump too big");
-    enc->data[pos - 1] = (unsigned char)where;
-}
+    assert(size > 0 && enc->cached_size == 0);
+    enc_store(enc);
+    enc->need_load = 1;
+    if (size < 8)
+    {
+        for (int32_t i = 0; i != size; ++i)
+            enc_write_byte4(enc, 0xC6, 0x45, (unsigned char)i, data[i]); // mov  byte ptr [rbp+<i>], <imm>
+        return;
+    }
 
-static bf_jumpdata enc_jmp_helper_backward_start(bf_jit_encoder* enc)
-{
-    return enc->size;
+    // the last qword is copied first, the loop copies the whole ones before it
+    enc_write_byte3(enc, 0x48, 0x8D, 0x15);
+    enc_write_rodata_ref(enc, data, (size_t)size);                     // lea  rdx, [rip+<data>]
+    enc_write_byte3(enc, 0x48, 0x8B, 0x82);
+    enc_write_int(enc, size - 8);                                       // mov  rax, qword ptr [rdx+<size - 8>]
+    enc_write_byte3(enc, 0x48, 0x89, 0x85);
+    enc_write_int(enc, size - 8);                                       // mov  qword ptr [rbp+<size - 8>], rax
+    enc_write_byte(enc, 0xB9);
+    enc_write_int(enc, size / 8 * 8);                                   // mov  ecx, <size / 8 * 8>
+    bf_jumpdata j = enc_jmp_helper_backward_start(enc);                 // loop:
+    enc_write_byte4(enc, 0x48, 0x8B, 0x44, 0x0A);
+    enc_write_byte(enc, 0xF8);                                          // mov  rax, qword ptr [rdx+rcx-8]
+    enc_write_byte4(enc, 0x48, 0x89, 0x44, 0x0D);
+    enc_write_byte(enc, 0xF8);                                          // mov  qword ptr [rbp+rcx-8], rax
+    enc_write_byte3(enc, 0x83, 0xE9, 0x08);                             // sub  ecx, 8
+    enc_jmp_helper_backward_finish(enc, 0x75, j);                       // jnz  <loop>
 }
 
-static void enc_jmp_helper_backward_finish(bf_jit_encoder* enc, bf_jumpdata pos)
-{
-    ptrdiff_t where = pos - enc->size;
-    if (where < -128)
-        bf_error("jump too big");
-    enc->data[enc->size - 1] = (unsigned char)where;
-}
+#define BF_SCAN_MAX_SIMD_STRIDE 8
 
 void bf_jit_start_copy_seq(bf_jit_encoder* enc)
 {
+    // the state after the sequence is the one its body leaves, which may
+    // have written the cell back
     enc_load(enc);
-    enc_write_byte2(enc, 0x84, 0xDB);                                   // test bl, bl
-    enc_write_byte2(enc, 0x74, 0x00);                                   // jz   <end>
-    enc->copy_loop_start = enc_jmp_helper_forward_start(enc);
+    enc_store(enc);
+    enc_test_cell(enc);
+    enc->copy_loop_start = enc_jmp_helper_forward_start(enc, 0x74);     // jz   <end>
 }
 
 void bf_jit_finish_copy_seq(bf_jit_encoder* enc)
@@ -525,6 +1418,14 @@ void bf_jit_finish_copy_seq(bf_jit_encoder* enc)
     enc_jmp_helper_forward_finish(enc, enc->copy_loop_start);           // end:
 }
 
+// add or subtract bl (or al when multiplied) to the register of a cached cell
+static void enc_copyop_cached(bf_jit_encoder* enc, const bf_cached_cell* c, int32_t mul, unsigned char src)
+{
+    enc_rex_rm8(enc, c->reg);
+    enc_write_byte2(enc, mul > 0 ? 0x00 : 0x28,
+                    (unsigned char)(0xC0 | src << 3 | (c->reg & 7)));   // add/sub <reg>, bl/al
+}
+
 static void enc_copyop_impl(bf_jit_encoder* enc, int32_t off, int32_t mul)
 {
     if (mul > 0 && -129 < off && off < 128)
@@ -547,10 +1448,38 @@ static void enc_copyop_impl(bf_jit_encoder* enc, int32_t off, int32_t mul)
     }
 }
 
-static void enc_copyop_impl_mul(bf_jit_encoder* enc, int32_t off, int32_t mul)
+// adds or subtracts al to the cell at 'off'
+static void enc_copyop_al(bf_jit_encoder* enc, const bf_cached_cell* c, int32_t off, int32_t mul)
+{
+    if (c)
+    {
+        enc_copyop_cached(enc, c, mul, 0);
+    }
+    else if (mul > 0 && -129 < off && off < 128)
+    {
+        enc_write_byte3(enc, 0x00, 0x45, (unsigned char)off);           // add  byte ptr [rbp+<off>], al
+    }
+    else if (mul > 0)
+    {
+        enc_write_byte2(enc, 0x00, 0x85);
+        enc_write_int(enc, off);                                        // add  byte ptr [rbp+<off>], al
+    }
+    else if (-129 < off && off < 128)
+    {
+        enc_write_byte3(enc, 0x28, 0x45, (unsigned char)off);           // sub  byte ptr [rbp+<off>], al
+    }
+    else
+    {
+        enc_write_byte2(enc, 0x28, 0x85);
+        enc_write_int(enc, off);                                        // sub  byte ptr [rbp+<off>], al
+    }
+}
+
+static void enc_copyop_impl_mul(bf_jit_encoder* enc, const bf_cached_cell* c, int32_t off, int32_t mul)
 {
     uint32_t multiplier = mul > 0 ? mul : -mul;
 
+    // index scaled without a base takes a zero disp32, powers of two are shifted instead
     switch (multiplier)
     {
     case 2:
@@ -559,10 +1488,6 @@ static void enc_copyop_impl_mul(bf_jit_encoder* enc, int32_t off, int32_t mul)
     case 3:
         enc_write_byte3(enc, 0x8D, 0x04, 0x5B);                         // lea  eax, [rbx + rbx * 2]
         break;
-    case 4:
-        enc_write_byte3(enc, 0x8D, 0x04, 0x9D);                         // lea  eax, [rbx * 4]
-        enc_write_int(enc, 0);
-        break;
     case 5:
         enc_write_byte3(enc, 0x8D, 0x04, 0x9B);                         // lea  eax, [rbx + rbx * 4]
         break;
@@ -571,13 +1496,8 @@ static void enc_copyop_impl_mul(bf_jit_encoder* enc, int32_t off, int32_t mul)
         enc_write_byte2(enc, 0x01, 0xC0);                               // add  eax, eax
         break;
     case 7:
-        enc_write_byte3(enc, 0x8D, 0x04, 0xDD);                         // lea  eax, [rbx * 8]
-        enc_write_int(enc, 0);
-        enc_write_byte2(enc, 0x29, 0xD8);                               // sub  eax, ebx
-        break;
-    case 8:
-        enc_write_byte3(enc, 0x8D, 0x04, 0xDD);                         // lea  eax, [rbx * 8]
-        enc_write_int(enc, 0);
+        enc_write_byte3(enc, 0x8D, 0x04, 0x5B);                         // lea  eax, [rbx + rbx * 2]
+        enc_write_byte3(enc, 0x8D, 0x04, 0x43);                         // lea  eax, [rbx + rax * 2]
         break;
     case 9:
         enc_write_byte3(enc, 0x8D, 0x04, 0xDB);                         // lea  eax, [rbx + rbx * 8]
@@ -603,40 +1523,197 @@ static void enc_copyop_impl_mul(bf_jit_encoder* enc, int32_t off, int32_t mul)
         }
         else
         {
-            enc_write_byte(enc, 0xB9);
-            enc_write_int(enc, multiplier);                             // mov  ecx, <multiplier>
-            enc_write_byte2(enc, 0xF7, 0xE1);                           // mul  ecx
+            enc_write_byte2(enc, 0x69, 0xC0);
+            enc_write_int(enc, multiplier);                             // imul eax, eax, <multiplier>
         }
     }
 
-    if (mul > 0 && -129 < off && off < 128)
-    {
-        enc_write_byte3(enc, 0x00, 0x45, (unsigned char)off);           // add  byte ptr [rbp+<off>], al
-    }
-    else if (mul > 0)
-    {
-        enc_write_byte2(enc, 0x00, 0x85);
-        enc_write_int(enc, off);                                        // add  byte ptr [rbp+<off>], al
-    }
-    else if (-129 < off && off < 128)
+    enc_copyop_al(enc, c, off, mul);
+}
+
+void bf_jit_encode_productop_unsafe(bf_jit_encoder* enc, int32_t off, int32_t src)
+{
+    assert(off != 0 && src != 0 && off != src);
+    enc_load(enc);
+    const bf_cached_cell* s = enc_find_cached(enc, src);
+    if (s)
     {
-        enc_write_byte3(enc, 0x28, 0x45, (unsigned char)off);           // sub  byte ptr [rbp+<off>], al
+        enc_rex_rm8(enc, s->reg);
+        enc_write_byte2(enc, 0x8A, (unsigned char)(0xC0 | (s->reg & 7))); // mov  al, <reg>
     }
     else
     {
-        enc_write_byte2(enc, 0x28, 0x85);
-        enc_write_int(enc, off);                                        // sub  byte ptr [rbp+<off>], al
+        enc_reg8_rbp(enc, 0x8A, 0, src);                                // mov  al, byte ptr [rbp+<src>]
     }
+    enc_write_byte2(enc, 0xF6, 0xE3);                                   // mul  bl
+    enc_copyop_al(enc, enc_find_cached(enc, off), off, 1);
 }
 
 void bf_jit_encode_copyop_unsafe(bf_jit_encoder* enc, int32_t off, int32_t mul)
 {
     assert(off != 0 && mul != 0);
     enc_load(enc);
-    if (mul == 1 || mul == -1)
+    const bf_cached_cell* c = enc_find_cached(enc, off);
+    if (c && (mul == 1 || mul == -1))
+        enc_copyop_cached(enc, c, mul, 3);
+    else if (mul == 1 || mul == -1)
         enc_copyop_impl(enc, off, mul);
     else
-        enc_copyop_impl_mul(enc, off, mul);
+        enc_copyop_impl_mul(enc, c, off, mul);
+}
+
+static void enc_scanop_scalar(bf_jit_encoder* enc, int32_t off)
+{
+    bf_jumpdata j = enc_jmp_helper_backward_start(enc);                     // loop_start:
+    bf_jit_encode_check(enc, off);
+    enc_encode_next_impl(enc, off);
+
+    enc_write_byte4(enc, 0x80, 0x7D, 0x00, 0x00);                           // cmp  byte ptr [rbp], 0
+    enc_jmp_helper_backward_finish(enc, 0x75, j);                           // jnz  <loop_start>
+}
+
+// steps of a checked scan between two bounds checks
+#define BF_SCAN_UNROLL 4
+
+static void enc_scanop_unrolled(bf_jit_encoder* enc, int32_t off)
+{
+    /*  Checks that the pointer stays in bounds for the next few steps once
+     *  and then makes them without checks. Steps that cross the end of the
+     *  tape are handed over to the scalar loop.
+     */
+    int32_t block = off * BF_SCAN_UNROLL;
+    assert(-128 <= block && block <= 127);
+
+    bf_jit_encode_loop_align(enc);
+    bf_jumpdata j_loop = enc_jmp_helper_backward_start(enc);                // loop_start:
+    bf_jumpdata j_tail;
+    enc_write_byte4(enc, 0x48, 0x8D, 0x45, (unsigned char)block);           // lea  rax, [rbp+<block>]
+    if (off > 0)
+    {
+        enc_write_byte3(enc, 0x4C, 0x39, 0xF0);                             // cmp  rax, r14
+        j_tail = enc_jmp_helper_forward_start(enc, 0x7D);                   // jge  <tail>
+    }
+    else
+    {
+        enc_write_byte3(enc, 0x4C, 0x39, 0xE8);                             // cmp  rax, r13
+        j_tail = enc_jmp_helper_forward_start(enc, 0x7C);                   // jl   <tail>
+    }
+
+    bf_jumpdata j_found[BF_SCAN_UNROLL - 1];
+    for (int i = 0; i != BF_SCAN_UNROLL; ++i)
+    {
+        enc_write_byte4(enc, 0x48, 0x83, 0xC5, (unsigned char)off);         // add  rbp, <off>
+        enc_write_byte4(enc, 0x80, 0x7D, 0x00, 0x00);                       // cmp  byte ptr [rbp], 0
+        if (i != BF_SCAN_UNROLL - 1)
+        {
+            j_found[i] = enc_jmp_helper_forward_start(enc, 0x74);           // jz   <end>
+        }
+    }
+    enc_jmp_helper_backward_finish(enc, 0x75, j_loop);                      // jnz  <loop_start>
+    bf_jumpdata j_end = enc_jmp_helper_forward_start(enc, 0xEB);            // jmp  <end>
+
+    enc_jmp_helper_forward_finish(enc, j_tail);                             // tail:
+    enc_scanop_scalar(enc, off);
+    for (int i = 0; i != BF_SCAN_UNROLL - 1; ++i)
+        enc_jmp_helper_forward_finish(enc, j_found[i]);
+    enc_jmp_helper_forward_finish(enc, j_end);                              // end:
+}
+
+static void enc_scanop_vector(bf_jit_encoder* enc, int32_t off)
+{
+    /*  Compares whole block of cells with zero at once and masks out cells
+     *  which are not visited by the scan. Block is loaded so that its first
+     *  (or last for backward scans) byte is the next visited cell, reads past
+     *  the visited cells are covered by tape padding.
+     *  Bounds are checked once per block, block that crosses the end of the
+     *  tape is handed over to the scalar loop. Tapes with guard pages have no
+     *  padding, there the whole loaded block has to be on the tape.
+     */
+    int ymm = enc->avx2 && (off == 1 || off == -1);
+    int32_t width = ymm ? 32 : 16;
+    int32_t step = off > 0 ? off : -off;
+    int32_t count = (width - 1) / step + 1;
+    int32_t disp = off > 0 ? off : off - (width - 1);
+
+    int32_t edge = off * count;
+    if (enc->rtc == BF_CHECK_GUARD)
+        edge = off > 0 ? disp + width - 1 : disp;
+
+    uint32_t mask = 0;
+    for (int32_t i = 0; i != count; ++i)
+        mask |= 1u << (off > 0 ? i * step : width - 1 - i * step);
+
+    if (ymm)
+        enc_write_byte4(enc, 0xC5, 0xFD, 0xEF, 0xC0);                       // vpxor ymm0, ymm0, ymm0
+    else
+        enc_write_byte4(enc, 0x66, 0x0F, 0xEF, 0xC0);                       // pxor xmm0, xmm0
+
+    bf_jit_encode_loop_align(enc);
+    bf_jumpdata j_loop = enc_jmp_helper_backward_start(enc);                // loop_start:
+    bf_jumpdata j_tail = 0;
+    if (enc->rtc)
+    {
+        enc_write_byte4(enc, 0x48, 0x8D, 0x45, (unsigned char)edge);      // lea  rax, [rbp+<edge>]
+        if (off > 0)
+        {
+            enc_write_byte3(enc, 0x4C, 0x39, 0xF0);                         // cmp  rax, r14
+            j_tail = enc_jmp_helper_forward_start(enc, 0x7D);               // jge  <tail>
+        }
+        else
+        {
+            enc_write_byte3(enc, 0x4C, 0x39, 0xE8);                         // cmp  rax, r13
+            j_tail = enc_jmp_helper_forward_start(enc, 0x7C);               // jl   <tail>
+        }
+    }
+
+    if (ymm)
+    {
+        enc_write_byte4(enc, 0xC5, 0xFE, 0x6F, 0x4D);
+        enc_write_byte(enc, (unsigned char)disp);                           // vmovdqu ymm1, [rbp+<disp>]
+        enc_write_byte4(enc, 0xC5, 0xF5, 0x74, 0xC8);                       // vpcmpeqb ymm1, ymm1, ymm0
+        enc_write_byte4(enc, 0xC5, 0xFD, 0xD7, 0xC1);                       // vpmovmskb eax, ymm1
+    }
+    else
+    {
+        enc_write_byte4(enc, 0xF3, 0x0F, 0x6F, 0x4D);
+        enc_write_byte(enc, (unsigned char)disp);                           // movdqu xmm1, [rbp+<disp>]
+        enc_write_byte4(enc, 0x66, 0x0F, 0x74, 0xC8);                       // pcmpeqb xmm1, xmm0
+        enc_write_byte4(enc, 0x66, 0x0F, 0xD7, 0xC1);                       // pmovmskb eax, xmm1
+    }
+
+    if (count == width)
+    {
+        enc_write_byte2(enc, 0x85, 0xC0);                                   // test eax, eax
+    }
+    else
+    {
+        enc_write_byte(enc, 0x25);
+        enc_write_int(enc, (int)mask);                                      // and  eax, <mask>
+    }
+    bf_jumpdata j_found = enc_jmp_helper_forward_start(enc, 0x75);          // jnz  <found>
+    enc_encode_next_impl(enc, off * count);
+    enc_jmp_helper_backward_finish(enc, 0xEB, j_loop);                      // jmp  <loop_start>
+
+    enc_jmp_helper_forward_finish(enc, j_found);                            // found:
+    if (off > 0)
+        enc_write_byte3(enc, 0x0F, 0xBC, 0xC0);                             // bsf  eax, eax
+    else
+        enc_write_byte3(enc, 0x0F, 0xBD, 0xC0);                             // bsr  eax, eax
+    enc_write_byte4(enc, 0x48, 0x8D, 0x6C, 0x05);
+    enc_write_byte(enc, (unsigned char)disp);                               // lea  rbp, [rbp+rax+<disp>]
+    if (ymm)
+        enc_write_byte3(enc, 0xC5, 0xF8, 0x77);                             // vzeroupper
+
+    if (enc->rtc)
+    {
+        bf_jumpdata j_end = enc_jmp_helper_forward_start(enc, 0xEB);        // jmp  <end>
+
+        enc_jmp_helper_forward_finish(enc, j_tail);                         // tail:
+        if (ymm)
+            enc_write_byte3(enc, 0xC5, 0xF8, 0x77);                         // vzeroupper
+        enc_scanop_scalar(enc, off);
+        enc_jmp_helper_forward_finish(enc, j_end);                          // end:
+    }
 }
 
 void bf_jit_encode_scanop(bf_jit_encoder* enc, int32_t off, int skip_init)
@@ -646,25 +1723,30 @@ void bf_jit_encode_scanop(bf_jit_encoder* enc, int32_t off, int skip_init)
      *    bf_jit_encode_next(enc, off);
      *    bf_jit_encode_loop_end(enc);
      *  but moves memory write from 'next' out of the loop.
+     *  Short strides are scanned with SIMD compares, see enc_scanop_vector,
+     *  longer ones check bounds once per few steps, see enc_scanop_unrolled.
      */
     assert(off != 0);
+    // the cell has to be written back when the loop is skipped as well
+    enc_store(enc);
     bf_jumpdata j1 = 0;
     if (!skip_init)
     {
         enc_load(enc);
-        enc_write_byte2(enc, 0x84, 0xDB);                                   // test bl, bl
-        enc_write_byte2(enc, 0x74, 0x00);                                   // jz   <loop_end>
-        j1 = enc_jmp_helper_forward_start(enc);
+        enc_test_cell(enc);
+        j1 = enc_jmp_helper_forward_start(enc, 0x74);                       // jz   <loop_end>
     }
-    enc_store(enc);
 
-    bf_jumpdata j2 = enc_jmp_helper_backward_start(enc);                    // loop_start:
-    bf_jit_encode_check(enc, off);
-    enc_encode_next_impl(enc, off);
+    if (-BF_SCAN_MAX_SIMD_STRIDE <= off && off <= BF_SCAN_MAX_SIMD_STRIDE)
+        enc_scanop_vector(enc, off);
+    else if (enc->rtc == BF_CHECK_INLINE && -128 / BF_SCAN_UNROLL <= off && off <= 127 / BF_SCAN_UNROLL)
+        enc_scanop_unrolled(enc, off);
+    else
+    {
+        bf_jit_encode_loop_align(enc);
+        enc_scanop_scalar(enc, off);
+    }
 
-    enc_write_byte4(enc, 0x80, 0x7D, 0x00, 0x00);                           // cmp  byte ptr [rbp], 0
-    enc_write_byte2(enc, 0x75, 0x00);                                       // jnz  <loop_start>
-    enc_jmp_helper_backward_finish(enc, j2);
     enc->need_load = 1;
     if (!skip_init)
         enc_jmp_helper_forward_finish(enc, j1);                             // loop_end:
@@ -1,347 +1,601 @@
+#include <assert.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "bfjit.h"
 #include "bfjit-codegen.h"
 #include "bfjit-compiler.h"
-#include "bfjit-io.h"
+#include "bfjit-ir.h"
 #include "bfjit-memory.h"
+#include "bfjit-profile.h"
+#include "bfjit-thread.h"
 
-typedef struct {
-    int32_t off;
-    int32_t op;
-} bf_off_op;
+// distinct offsets considered for caching in a single loop
+#define BF_CACHE_CANDIDATES 32
 
 typedef struct {
-    int pending_set;
-    int value_known;
-    unsigned char current_value;
-    int loop_counter_known;
-    unsigned char loop_counter;
-    int32_t offset;
-    int32_t inplace_op;
-    bf_off_op* offset_ops;
-    size_t offset_ops_size;
-    size_t offset_ops_cap;
-} bf_generator;
-
-static void bf_generator_init(bf_generator* gen)
-{
-    gen->pending_set = 0;
-    gen->value_known = 1;
-    gen->current_value = 0;
-    gen->loop_counter_known = 0;
-    gen->offset = 0;
-    gen->inplace_op = 0;
-    gen->offset_ops = NULL;
-    gen->offset_ops_size = 0;
-    gen->offset_ops_cap = 0;
-}
-
-static void bf_generator_clear_trivial_data(bf_generator* gen)
+    int32_t off;
+    uint32_t uses;
+} bf_cache_candidate;
+
+// nesting of ifs within a loop whose cells are cached
+#define BF_CACHE_MAX_DEPTH 16
+// cells and pointer positions stay this close to the loop start, so that
+// spills around runtime calls use short displacements and fit in short jumps
+#define BF_CACHE_MAX_OFFSET 63
+
+/*
+ *  Picks cells kept in registers for the whole body of the loop starting
+ *  at 'begin'. Only loops that contain no other loops and return the tape
+ *  pointer to where it started qualify, so that every cell has a fixed
+ *  offset from the loop start. Cells accessed unconditionally and never
+ *  visited by the pointer itself are chosen by the number of accesses.
+ *  With bounds checking they must also be known to be in bounds on every
+ *  iteration.
+ */
+static size_t bf_loop_cached_cells(const bf_ir* ir, size_t begin, int rtc, int32_t* offs)
 {
-    gen->pending_set = 0;
-    gen->offset = 0;
-    gen->inplace_op = 0;
-    gen->offset_ops_size = 0;
-}
+    const bf_ir_op* loop = &ir->ops[begin];
+    const bf_ir_op* end = &ir->ops[loop->link];
+    if (end->flags & BF_IR_ONCE)
+        return 0;
 
-static void bf_generator_add_op(bf_generator* gen, int32_t op)
-{
-    if (gen->offset == 0)
+    int32_t min = -BF_CACHE_MAX_OFFSET;
+    int32_t max = BF_CACHE_MAX_OFFSET;
+    if (rtc != BF_CHECK_NONE)
     {
-        gen->inplace_op += op;
-        return;
+        if (end->off > min)
+            min = end->off;
+        if (end->val < max)
+            max = end->val;
     }
 
-    for (size_t i = 0; i != gen->offset_ops_size; ++i)
+    bf_cache_candidate cands[BF_CACHE_CANDIDATES];
+    size_t count = 0;
+    int32_t visited[BF_CACHE_CANDIDATES];
+    size_t visited_size = 1;
+    visited[0] = 0;
+    int32_t ifs[BF_CACHE_MAX_DEPTH];
+    size_t depth = 0;
+    int32_t pos = 0;
+    for (size_t i = begin + 1; i != loop->link; ++i)
     {
-        if (gen->offset_ops[i].off == gen->offset)
+        const bf_ir_op* op = &ir->ops[i];
+        switch (op->kind)
         {
-            gen->offset_ops[i].op += op;
-            return;
+        case BF_IR_SCAN:
+        case BF_IR_LOOP:
+            return 0;
+        case BF_IR_MOVE:
+        {
+            pos += op->val;
+            if (pos < -BF_CACHE_MAX_OFFSET || pos > BF_CACHE_MAX_OFFSET)
+                return 0;
+            size_t j = 0;
+            while (j != visited_size && visited[j] != pos)
+                ++j;
+            if (j == BF_CACHE_CANDIDATES)
+                return 0;
+            if (j == visited_size)
+                visited[visited_size++] = pos;
+            break;
+        }
+        case BF_IR_IF:
+            if (depth == BF_CACHE_MAX_DEPTH)
+                return 0;
+            ifs[depth++] = pos;
+            break;
+        case BF_IR_END:
+            // pointer must be in the same place whether the if is entered or not
+            if (ifs[--depth] != pos)
+                return 0;
+            break;
+        case BF_IR_ADD:
+        case BF_IR_SET:
+        case BF_IR_MUL:
+        case BF_IR_PRODUCT:
+        {
+            int32_t cell = pos + op->off;
+            if (op->off == 0 || depth != 0 || cell < min || cell > max)
+                break;
+            size_t j = 0;
+            while (j != count && cands[j].off != cell)
+                ++j;
+            if (j == count && count != BF_CACHE_CANDIDATES)
+            {
+                cands[count].off = cell;
+                cands[count].uses = 0;
+                ++count;
+            }
+            if (j != count)
+                ++cands[j].uses;
+            break;
+        }
+        default:
+            break;
         }
     }
+    if (pos != 0)
+        return 0;
 
-    if (gen->offset_ops_size == gen->offset_ops_cap)
+    // cells under the pointer are kept in bl while it is there
+    size_t kept = 0;
+    for (size_t i = 0; i != count; ++i)
     {
-        size_t newcap = (gen->offset_ops_cap == 0) ? 16 : (gen->offset_ops_cap * 2);
-        gen->offset_ops = bf_realloc(gen->offset_ops, newcap * sizeof(bf_off_op));
-        gen->offset_ops_cap = newcap;
+        size_t j = 0;
+        while (j != visited_size && visited[j] != cands[i].off)
+            ++j;
+        if (j == visited_size)
+            cands[kept++] = cands[i];
     }
-    bf_off_op newop;
-    newop.off = gen->offset;
-    newop.op = op;
-    gen->offset_ops[gen->offset_ops_size++] = newop;
+    count = kept;
+
+    // most used first, stable for equal counts
+    for (size_t i = 1; i < count; ++i)
+    {
+        bf_cache_candidate c = cands[i];
+        size_t j = i;
+        for (; j != 0 && cands[j - 1].uses < c.uses; --j)
+            cands[j] = cands[j - 1];
+        cands[j] = c;
+    }
+
+    if (count > BF_MAX_CACHED_CELLS)
+        count = BF_MAX_CACHED_CELLS;
+    for (size_t i = 0; i != count; ++i)
+        offs[i] = cands[i].off;
+    return count;
+}
+
+static void bf_lower_check(const bf_ir_op* op, bf_jit_encoder* enc)
+{
+    if (op->flags & BF_IR_PROBE)
+    {
+        bf_jit_encode_probe(enc, op->off);
+        return;
+    }
+    if (op->off != 0)
+        bf_jit_encode_check(enc, op->off);
+    if (op->val != 0)
+        bf_jit_encode_check(enc, op->val);
 }
 
-static void bf_flush_trivial_ops(bf_jit_encoder* enc, bf_generator* gen)
+static void bf_lower_loop_cache(const bf_ir* ir, size_t begin, int rtc, bf_jit_encoder* enc)
 {
-    int32_t delayed_op = 0;
+    int32_t offs[BF_MAX_CACHED_CELLS];
+    size_t count = bf_loop_cached_cells(ir, begin, rtc, offs);
+    if (count != 0)
+        bf_jit_encode_loop_cache_cells(enc, offs, count);
+}
 
-    int32_t min = 0;
-    int32_t max = 0;
-    for (uint32_t i = 0; i != gen->offset_ops_size; ++i)
+static void bf_osr_push(bf_osr_table* osr, const bf_osr_entry* entry)
+{
+    if (osr->size == osr->cap)
     {
-        int32_t off = gen->offset_ops[i].off;
-        if (off < min)
-            min = off;
-        if (off > max)
-            max = off;
+        osr->cap = (osr->cap == 0) ? 16 : (osr->cap * 2);
+        osr->entries = bf_realloc(osr->entries, osr->cap * sizeof(bf_osr_entry));
     }
+    osr->entries[osr->size++] = *entry;
+}
 
-    if (gen->offset < min)
-        min = gen->offset;
-    if (gen->offset > max)
-        max = gen->offset;
+static void bf_osr_add(bf_osr_table* osr, const bf_ir_op* loop, size_t entry)
+{
+    bf_osr_entry e;
+    e.src = loop->src;
+    e.lo = loop->off;
+    e.hi = loop->val;
+    e.entry = entry;
+    bf_osr_push(osr, &e);
+}
 
-    if (min != 0)
-        bf_jit_encode_check(enc, min);
-    if (max != 0)
-        bf_jit_encode_check(enc, max);
+// counts entries of the source loop 'op' replaces if it is the first op doing
+// so, returns the index of the loop or -1
+static int64_t bf_lower_profile(bf_profile* profile, const bf_ir_op* op, bf_profile_kind kind, bf_jit_encoder* enc)
+{
+    if (!profile)
+        return -1;
+    int64_t i = bf_profile_find(profile, op->src);
+    if (i == -1 || profile->loops[i].kind != BF_PROFILE_REMOVED)
+        return -1;
+    profile->loops[i].kind = kind;
+    bf_jit_encode_count(enc, (uint32_t)(2 * i));
+    return i;
+}
 
-    for (size_t i = 0; i != gen->offset_ops_size; ++i)
+// loops without loops in them run the most iterations
+static int bf_is_innermost_loop(const bf_ir* ir, size_t begin)
+{
+    for (size_t i = begin + 1; i != ir->ops[begin].link; ++i)
     {
-        int32_t off = gen->offset_ops[i].off;
-        int32_t op = gen->offset_ops[i].op;
+        if (ir->ops[i].kind == BF_IR_LOOP)
+            return 0;
+    }
+    return 1;
+}
 
-        if (off == gen->offset)
+static void bf_lower_ir(const bf_ir* ir, const bf_ir_options* opts, bf_jit_encoder* enc, const bf_compile_info* info)
+{
+    bf_osr_table* osr = info->osr;
+    bf_profile* profile = info->profile;
+    bf_code_map* map = info->code_map;
+    bf_source_map* source_map = info->source_map;
+    // regions of open loops
+    size_t* regions = NULL;
+    size_t regions_size = 0;
+    size_t regions_cap = 0;
+
+    for (size_t i = 0; i != ir->size; ++i)
+    {
+        const bf_ir_op* op = &ir->ops[i];
+        if (source_map && op->src != BF_IR_NO_SRC)
+        {
+            uint32_t line, col;
+            bf_ir_source_position(ir, op->src, &line, &col);
+            bf_source_map_push(source_map, bf_jit_encoder_offset(enc), line, col);
+        }
+        switch (op->kind)
+        {
+        case BF_IR_ADD:
+            if (op->off == 0)
+                bf_jit_encode_add(enc, op->val);
+            else
+                bf_jit_encode_offop_unsafe(enc, op->val, op->off);
+            break;
+        case BF_IR_SET:
+            bf_lower_profile(profile, op, BF_PROFILE_SET, enc);
+            if (op->off == 0)
+                bf_jit_encode_set(enc, op->val);
+            else
+                bf_jit_encode_set_offset_unsafe(enc, op->val, op->off);
+            break;
+        case BF_IR_MOVE:
+            bf_jit_encode_next_unsafe(enc, op->val);
+            break;
+        case BF_IR_INPUT:
+            assert(op->off == 0);
+            bf_jit_encode_input(enc);
+            break;
+        case BF_IR_OUTPUT:
+            assert(op->off == 0);
+            if (op->val == 1)
+                bf_jit_encode_output(enc);
+            else
+                bf_jit_encode_output_repeat(enc, op->val);
+            break;
+        case BF_IR_WRITE:
+            bf_jit_encode_write(enc, ir->data + op->off, op->val);
+            break;
+        case BF_IR_INIT:
+            bf_jit_encode_init(enc, ir->data + op->off, op->val);
+            break;
+        case BF_IR_LOOP:
+        {
+            if (osr)
+                bf_osr_add(osr, op, bf_jit_encode_osr_entry(enc));
+            if (map)
+            {
+                uint32_t line, col;
+                bf_ir_source_position(ir, op->src, &line, &col);
+                if (regions_size == regions_cap)
+                {
+                    regions_cap = (regions_cap == 0) ? 16 : (regions_cap * 2);
+                    regions = bf_realloc(regions, regions_cap * sizeof(size_t));
+                }
+                regions[regions_size++] = bf_code_map_push(map, bf_jit_encoder_offset(enc), line, col);
+            }
+            int64_t counted = bf_lower_profile(profile, op, BF_PROFILE_LOOP, enc);
+            if (op->flags & BF_IR_ENTERED)
+                bf_jit_encode_loop_start_optimized(enc);
+            else
+                bf_jit_encode_loop_start(enc);
+            // code up to the loop head runs once on entry
+            if (op[1].kind == BF_IR_CHECK && (op[1].flags & BF_IR_HOISTED))
+                bf_lower_check(&op[1], enc);
+            if (opts->opt_level >= 2)
+                bf_lower_loop_cache(ir, i, opts->rtc, enc);
+            if (opts->opt_level >= 1 && bf_is_innermost_loop(ir, i))
+                bf_jit_encode_loop_align(enc);
+            bf_jit_encode_loop_head(enc);
+            if (counted != -1)
+                bf_jit_encode_count(enc, (uint32_t)(2 * counted + 1));
+            break;
+        }
+        case BF_IR_IF:
+            bf_lower_profile(profile, op, BF_PROFILE_COPY, enc);
+            if (!(op->flags & BF_IR_ENTERED))
+                bf_jit_start_copy_seq(enc);
+            break;
+        case BF_IR_END:
         {
-            delayed_op = op;
-            continue;
+            const bf_ir_op* begin = &ir->ops[op->link];
+            if (begin->kind == BF_IR_IF)
+            {
+                if (!(begin->flags & BF_IR_ENTERED))
+                    bf_jit_finish_copy_seq(enc);
+            }
+            else if (op->flags & BF_IR_ONCE)
+            {
+                bf_jit_encode_loop_end_optimized(enc);
+            }
+            else
+            {
+                bf_jit_encode_loop_end(enc);
+            }
+            if (map && begin->kind == BF_IR_LOOP)
+                map->regions[regions[--regions_size]].end = bf_jit_encoder_offset(enc);
+            break;
+        }
+        case BF_IR_SCAN:
+            bf_lower_profile(profile, op, BF_PROFILE_SCAN, enc);
+            bf_jit_encode_scanop(enc, op->val, (op->flags & BF_IR_ENTERED) != 0);
+            break;
+        case BF_IR_MUL:
+            // without the if when the cell is known to be non-zero
+            bf_lower_profile(profile, op, BF_PROFILE_COPY, enc);
+            bf_jit_encode_copyop_unsafe(enc, op->off, op->val);
+            break;
+        case BF_IR_PRODUCT:
+            bf_lower_profile(profile, op, BF_PROFILE_COPY, enc);
+            bf_jit_encode_productop_unsafe(enc, op->off, op->val);
+            break;
+        case BF_IR_CHECK:
+            if (!(op->flags & BF_IR_HOISTED))
+                bf_lower_check(op, enc);
+            break;
         }
-        if (op != 0)
-            bf_jit_encode_offop_unsafe(enc, op, off);
     }
+    bf_free(regions);
+}
 
-    if (gen->pending_set || (gen->inplace_op && gen->value_known == 1))
+// smallest guard size that makes explicit checks of the program unnecessary
+static size_t bf_guard_size(const bf_ir* ir)
+{
+    size_t size = BF_GUARD_MIN_SIZE;
+    for (size_t i = 0; i != ir->size; ++i)
     {
-        gen->current_value = (unsigned char)(gen->current_value + gen->inplace_op);
-        bf_jit_encode_set(enc, gen->current_value);
+        const bf_ir_op* op = &ir->ops[i];
+        int64_t extent = 0;
+        if (op->kind == BF_IR_CHECK)
+            extent = (-(int64_t)op->off > op->val) ? -(int64_t)op->off : op->val;
+        else if (op->kind == BF_IR_SCAN)
+            extent = (op->val < 0) ? -(int64_t)op->val : op->val;
+
+        if ((size_t)extent >= size)
+            size = (size_t)extent + 1;
     }
-    else if (gen->inplace_op)
+    return (size > BF_GUARD_MAX_SIZE) ? BF_GUARD_MAX_SIZE : size;
+}
+
+/*
+ *  Parallel compilation. Programs are split into parts before loops on the
+ *  top level, the parts are optimized and encoded on a pool of threads and
+ *  appended in order. Parts after the first one are optimized knowing nothing
+ *  about the tape they start with, and don't keep the current cell in bl
+ *  across their boundaries.
+ */
+
+// parts are at least this long in parsed ops, shorter programs are compiled whole
+#define BF_PART_MIN_OPS 4096
+// parts per thread, so that threads done early take over work of the others
+#define BF_PARTS_PER_THREAD 4
+
+typedef struct {
+    size_t begin;           // ops of the parsed program
+    size_t end;
+    bf_ir ir;
+    size_t guard_size;
+    bf_jit_encoder* enc;
+    bf_osr_table osr;
+    bf_code_map code_map;
+    bf_source_map source_map;
+} bf_part;
+
+typedef struct {
+    const bf_ir* ir;
+    const bf_ir_options* opts;
+    const bf_compile_info* info;
+    bf_jit_encoder* enc;
+    bf_part* parts;
+} bf_parts_job;
+
+// returns the number of parts, 'parts' is set only if there is more than one
+static size_t bf_split_parts(const bf_ir* ir, size_t threads, bf_part** parts)
+{
+    size_t min_ops = ir->size / (threads * BF_PARTS_PER_THREAD);
+    if (min_ops < BF_PART_MIN_OPS)
+        min_ops = BF_PART_MIN_OPS;
+    if (ir->size < 2 * min_ops)
+        return 1;
+
+    size_t count = 0;
+    size_t cap = 0;
+    size_t begin = 0;
+    size_t depth = 0;
+    *parts = NULL;
+    for (size_t i = 0; i <= ir->size; ++i)
     {
-        gen->value_known = 0;
-        bf_jit_encode_add(enc, gen->inplace_op);
+        int last = i == ir->size;
+        if (last || (ir->ops[i].kind == BF_IR_LOOP && depth == 0 && i - begin >= min_ops))
+        {
+            if (count == cap)
+            {
+                cap = (cap == 0) ? 16 : (cap * 2);
+                *parts = bf_realloc(*parts, cap * sizeof(bf_part));
+            }
+            bf_part* p = &(*parts)[count++];
+            memset(p, 0, sizeof(bf_part));
+            p->begin = begin;
+            p->end = i;
+            begin = i;
+        }
+        if (last)
+            break;
+        if (ir->ops[i].kind == BF_IR_LOOP)
+            ++depth;
+        else if (ir->ops[i].kind == BF_IR_END)
+            --depth;
     }
-
-    if (gen->offset)
+    if (count == 1)
     {
-        gen->value_known = 0;
-        bf_jit_encode_next_unsafe(enc, gen->offset);
+        bf_free(*parts);
+        *parts = NULL;
     }
-    if (delayed_op)
-        bf_jit_encode_add(enc, delayed_op);
+    return count;
+}
 
-    bf_generator_clear_trivial_data(gen);
+static void bf_part_optimize(void* arg, size_t index)
+{
+    bf_parts_job* job = arg;
+    bf_part* part = &job->parts[index];
+    size_t size = part->end - part->begin;
+
+    bf_ir_init(&part->ir);
+    part->ir.ops = bf_realloc(NULL, size * sizeof(bf_ir_op));
+    memcpy(part->ir.ops, job->ir->ops + part->begin, size * sizeof(bf_ir_op));
+    part->ir.size = size;
+    part->ir.cap = size;
+    // lines are only read, they stay owned by the whole program
+    part->ir.lines = job->ir->lines;
+    part->ir.lines_size = job->ir->lines_size;
+    bf_ir_link(&part->ir);
+
+    bf_ir_options opts = *job->opts;
+    opts.continued |= index != 0;
+    bf_ir_optimize(&part->ir, &opts);
+    part->guard_size = bf_guard_size(&part->ir);
 }
 
-static int bf_optimize_trivial_loop(bf_generator* gen, bf_jit_encoder* enc)
+static void bf_part_encode(void* arg, size_t index)
 {
-    if (gen->inplace_op == 0 && gen->offset == 0)
+    bf_parts_job* job = arg;
+    bf_part* part = &job->parts[index];
+    bf_compile_info info;
+    info.osr = job->info->osr ? &part->osr : NULL;
+    // parts count executions of distinct loops
+    info.profile = job->info->profile;
+    info.code_map = job->info->code_map ? &part->code_map : NULL;
+    info.source_map = job->info->source_map ? &part->source_map : NULL;
+
+    part->enc = bf_jit_encoder_new_part(job->enc);
+    bf_lower_ir(&part->ir, job->opts, part->enc, &info);
+    part->ir.lines = NULL;
+    bf_ir_free(&part->ir);
+}
+
+static void bf_compile_parts(const bf_ir* ir, bf_part* parts, size_t count, size_t threads, bf_jit_encoder* enc,
+                             const bf_ir_options* opts, const bf_compile_info* info)
+{
+    bf_parts_job job;
+    job.ir = ir;
+    job.opts = opts;
+    job.info = info;
+    job.enc = enc;
+    job.parts = parts;
+
+    bf_parallel_for(count, threads, bf_part_optimize, &job);
+    if (opts->rtc == BF_CHECK_GUARD)
     {
-        // infinite loop
-        // lets make it loop infinitely even faster by removing side effects
-        gen->offset_ops_size = 0;
-        return 0;
+        size_t guard_size = BF_GUARD_MIN_SIZE;
+        for (size_t i = 0; i != count; ++i)
+            if (parts[i].guard_size > guard_size)
+                guard_size = parts[i].guard_size;
+        bf_jit_encoder_set_guard_size(enc, guard_size);
     }
-    else if (gen->offset_ops_size == 0 && gen->inplace_op == 0)
+
+    bf_jit_encoder_set_osr(enc, info->osr != NULL);
+    bf_jit_encoder_init(enc);
+    bf_parallel_for(count, threads, bf_part_encode, &job);
+
+    for (size_t i = 0; i != count; ++i)
     {
-        bf_jit_pop_started_loop(enc);
-        bf_jit_encode_scanop(enc, gen->offset, gen->loop_counter_known != 0);
-        return 1;
+        bf_part* part = &parts[i];
+        size_t base = bf_jit_encoder_append_part(enc, part->enc);
+        for (size_t j = 0; j != part->osr.size; ++j)
+        {
+            bf_osr_entry e = part->osr.entries[j];
+            e.entry += base;
+            bf_osr_push(info->osr, &e);
+        }
+        if (info->code_map)
+            bf_code_map_append(info->code_map, &part->code_map, base);
+        if (info->source_map)
+            bf_source_map_append(info->source_map, &part->source_map, base);
+        bf_jit_encoder_free(part->enc);
+        bf_free(part->osr.entries);
+        bf_code_map_free(&part->code_map);
+        bf_source_map_free(&part->source_map);
     }
-    else if (gen->offset == 0 && gen->offset_ops_size == 0 &&
-             (gen->inplace_op == -1 || gen->inplace_op == 1))
+}
+
+// offsets in the results are taken while encoding, before jumps get their final size
+static bf_compiled_code bf_finish_code(bf_jit_encoder* enc, const bf_compile_info* info)
+{
+    bf_compiled_code code = bf_jit_encoder_finish(enc);
+    if (info->osr)
     {
-        bf_jit_pop_started_loop(enc);
-        return 2;
+        size_t cursor = 0;
+        for (size_t i = 0; i != info->osr->size; ++i)
+        {
+            bf_osr_entry* e = &info->osr->entries[i];
+            e->entry = bf_jit_encoder_relocate_next(enc, e->entry, &cursor);
+        }
     }
-    else if (gen->offset == 0 && gen->inplace_op == -1)
+    if (info->code_map)
     {
-        bf_jit_pop_started_loop(enc);
-
-        if (gen->loop_counter_known == 0)
-            bf_jit_start_copy_seq(enc);
-
-        int32_t min = 0;
-        int32_t max = 0;
-        for (uint32_t i = 0; i != gen->offset_ops_size; ++i)
+        for (size_t i = 0; i != info->code_map->size; ++i)
         {
-            int32_t off = gen->offset_ops[i].off;
-            if (off < min)
-                min = off;
-            if (off > max)
-                max = off;
+            bf_code_region* r = &info->code_map->regions[i];
+            r->begin = bf_jit_encoder_relocate(enc, r->begin);
+            r->end = bf_jit_encoder_relocate(enc, r->end);
         }
-
-        if (min != 0)
-            bf_jit_encode_check(enc, min);
-        if (max != 0)
-            bf_jit_encode_check(enc, max);
-
-        for (uint32_t i = 0; i != gen->offset_ops_size; ++i)
+    }
+    if (info->source_map)
+    {
+        size_t cursor = 0;
+        for (size_t i = 0; i != info->source_map->size; ++i)
         {
-            int32_t off = gen->offset_ops[i].off;
-            int32_t op = gen->offset_ops[i].op;
-            if (gen->loop_counter_known == 1 && op != 0)
-                bf_jit_encode_offop_unsafe(enc, op * gen->loop_counter, off);
-            else if (op != 0)
-                bf_jit_encode_copyop_unsafe(enc, off, op);
+            bf_source_pos* p = &info->source_map->positions[i];
+            p->offset = bf_jit_encoder_relocate_next(enc, p->offset, &cursor);
         }
-        if (gen->loop_counter_known == 0)
-            bf_jit_finish_copy_seq(enc);
-        return 2;
     }
-    return 0;
+    return code;
 }
 
-bf_compiled_code bf_compile_file(const char* filename, bf_jit_encoder* enc)
+bf_compiled_code bf_compile_ir(bf_ir* ir, bf_jit_encoder* enc, const bf_ir_options* opts, const bf_compile_info* info)
 {
-    bf_generator gen;
-    bf_generator_init(&gen);
-    bf_jit_encoder_init(enc);
-
-    bf_file file = bf_open_file_read(filename);
-    char input_buffer[8 * 1024];
-    size_t input_size;
-
-    int skipping_loop = 0;
-    unsigned unmatched = 0;
-
-    do
+    static const bf_compile_info none = {NULL, NULL, NULL, NULL};
+    if (!info)
+        info = &none;
+    if (info->profile)
+        bf_profile_init(info->profile, ir);
+
+    size_t threads = opts->jobs ? opts->jobs : bf_cpu_count();
+    bf_part* parts = NULL;
+    size_t count = (threads > 1) ? bf_split_parts(ir, threads, &parts) : 1;
+    if (count > 1)
     {
-        input_size = bf_read_file(file, input_buffer, sizeof(input_buffer));
-
-        for (const char* input = input_buffer; input != input_buffer + input_size; ++input)
-        {
-            if (skipping_loop)
-            {
-                if (*input == ']' && unmatched == 1)
-                    unmatched = 0, skipping_loop = 0;
-                else if (*input == ']')
-                    --unmatched;
-                else if (*input == '[')
-                    ++unmatched;
-                continue;
-            }
-
-            switch (*input)
-            {
-            case '-':
-            {
-                bf_generator_add_op(&gen, -1);
-                break;
-            }
-            case '+':
-            {
-                bf_generator_add_op(&gen, 1);
-                break;
-            }
-            case '<':
-            {
-                gen.offset -= 1;
-                break;
-            }
-            case '>':
-            {
-                gen.offset += 1;
-                break;
-            }
-            case '.':
-            {
-                bf_flush_trivial_ops(enc, &gen);
-                bf_jit_encode_output(enc);
-                break;
-            }
-            case ',':
-            {
-                bf_flush_trivial_ops(enc, &gen);
-                bf_jit_encode_input(enc);
-                gen.value_known = 0;
-                break;
-            }
-            case '[':
-            {
-                // if we know to be at zero, loop never gets executed - skip until matching ']'
-                if (gen.value_known == 1 && gen.current_value == 0 && gen.offset == 0 &&
-                    gen.inplace_op == 0)
-                {
-                    skipping_loop = 1;
-                    unmatched = 1;
-                    break;
-                }
-
-                bf_flush_trivial_ops(enc, &gen);
-
-                if ((gen.value_known == 1 && gen.current_value != 0) || gen.value_known == -1)
-                {
-                    if (gen.value_known == 1)
-                    {
-                        gen.loop_counter_known = 1;
-                        gen.loop_counter = gen.current_value;
-                    }
-                    else
-                    {
-                        gen.loop_counter_known = -1;
-                    }
-                    bf_jit_encode_loop_start_optimized(enc);
-                }
-                else
-                {
-                    gen.loop_counter_known = 0;
-                    bf_jit_encode_loop_start(enc);
-                }
-                gen.value_known = -1;
-                break;
-            }
-            case ']':
-            {
-                if (!bf_jit_is_in_loop(enc))
-                    bf_error("']' without a matching '['");
-
-                int loop_optimized = 0;
-                if (bf_jit_current_loop_size(enc) == 0 && !gen.pending_set)
-                    loop_optimized = bf_optimize_trivial_loop(&gen, enc);
-
-                if (loop_optimized)
-                {
-                    bf_generator_clear_trivial_data(&gen);
-                    if (loop_optimized == 2)
-                    {
-                        gen.pending_set = 1;
-                    }
-                }
-                else
-                {
-                    int delay_zero_set = gen.value_known == 1 && gen.current_value == 0 &&
-                                         gen.pending_set && gen.offset == 0 && gen.inplace_op == 0;
-
-                    if (delay_zero_set)
-                        gen.pending_set = 0;
-
-                    bf_flush_trivial_ops(enc, &gen);
-
-                    if (delay_zero_set)
-                        gen.pending_set = 1;
+        bf_compile_parts(ir, parts, count, threads, enc, opts, info);
+        bf_free(parts);
+        return bf_finish_code(enc, info);
+    }
 
-                    if (gen.value_known == 1 && gen.current_value == 0)
-                        bf_jit_encode_loop_end_optimized(enc);
-                    else
-                        bf_jit_encode_loop_end(enc);
-                }
-                gen.value_known = 1;
-                gen.current_value = 0;
-                gen.loop_counter_known = 0;
-                break;
-            }
-            }
-        }
-    } while (input_size == sizeof(input_buffer));
+    bf_ir_optimize(ir, opts);
+    if (opts->rtc == BF_CHECK_GUARD)
+        bf_jit_encoder_set_guard_size(enc, bf_guard_size(ir));
 
-    if (unmatched != 0 || bf_jit_is_in_loop(enc))
-        bf_error("'[' without a matching ']'");
+    bf_jit_encoder_set_osr(enc, info->osr != NULL);
+    bf_jit_encoder_init(enc);
+    bf_lower_ir(ir, opts, enc, info);
+    return bf_finish_code(enc, info);
+}
 
-    bf_close_file(file);
-    bf_free(gen.offset_ops);
-    return bf_jit_encoder_finish(enc);
+bf_compiled_code bf_compile_file(const char* filename, bf_jit_encoder* enc, const bf_ir_options* opts,
+                                 const bf_compile_info* info)
+{
+    bf_ir ir;
+    bf_ir_init(&ir);
+    bf_ir_parse_file(filename, &ir);
+    bf_compiled_code code = bf_compile_ir(&ir, enc, opts, info);
+    bf_ir_free(&ir);
+    return code;
 }
@@ -0,0 +1,39 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bfjit.h"
+#include "bfjit-error.h"
+#include "bfjit-thread.h"
+
+static BF_THREAD_LOCAL bf_error_trap* bf_trap;
+
+void bf_error_set_trap(bf_error_trap* trap)
+{
+    bf_trap = trap;
+}
+
+void bf_fail(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    bf_error_trap* trap = bf_trap;
+    if (trap)
+    {
+        vsnprintf(trap->message, sizeof(trap->message), format, args);
+        va_end(args);
+        // the trap is removed, errors of the code handling this one exit
+        bf_trap = NULL;
+#ifdef _WIN32
+        // jumps straight back without unwinding, compiled code has no unwind data
+        ((_JUMP_BUFFER*)&trap->env)->Frame = 0;
+#endif
+        longjmp(trap->env, 1);
+    }
+    fputs("error: ", stderr);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+    exit(1);
+}
@@ -0,0 +1,227 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+#include <stdint.h>
+#include <string.h>
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#ifndef __APPLE__
+#include <ucontext.h>
+#endif
+#endif
+
+#include "bfjit.h"
+#include "bfjit-guard.h"
+#include "bfjit-runtime.h"
+#include "bfjit-thread.h"
+
+#ifdef BF_HAVE_GUARD_PAGES
+
+// committed at once on a fault inside the growable part of the region
+#define BF_GUARD_COMMIT_SIZE (64 * 1024)
+
+// faults are handled on the thread that caused them, so every thread
+// running compiled code has its own region
+static BF_THREAD_LOCAL bf_guard_region bf_guard;
+// regions installed on all threads, the handler is there while it isn't zero
+static size_t bf_guard_count;
+
+/*
+ *  Compiled code keeps the runtime context in r12 and the output position
+ *  in r15. The faulting instruction is replaced by a call to out_of_bounds
+ *  with a null return address, which is fine since the function doesn't
+ *  return, passing the accessed address as the pointer, like failed checks
+ *  do, and the faulting instruction as the code position. Stack pointer is
+ *  adjusted as if the call was just made.
+ */
+
+#if defined _WIN32
+#define bf_reg_rip(ctx) ((ctx)->Rip)
+#define bf_reg_rsp(ctx) ((ctx)->Rsp)
+#define bf_reg_arg(ctx) ((ctx)->Rcx)
+#define bf_reg_arg2(ctx) ((ctx)->Rdx)
+#define bf_reg_arg3(ctx) ((ctx)->R8)
+#define bf_reg_r12(ctx) ((ctx)->R12)
+#define bf_reg_r15(ctx) ((ctx)->R15)
+// return address and shadow space for four register arguments
+#define BF_CALL_FRAME 40
+typedef CONTEXT bf_cpu_context;
+#elif defined __linux__
+#define bf_reg_rip(ctx) ((ctx)->uc_mcontext.gregs[REG_RIP])
+#define bf_reg_rsp(ctx) ((ctx)->uc_mcontext.gregs[REG_RSP])
+#define bf_reg_arg(ctx) ((ctx)->uc_mcontext.gregs[REG_RDI])
+#define bf_reg_arg2(ctx) ((ctx)->uc_mcontext.gregs[REG_RSI])
+#define bf_reg_arg3(ctx) ((ctx)->uc_mcontext.gregs[REG_RDX])
+#define bf_reg_r12(ctx) ((ctx)->uc_mcontext.gregs[REG_R12])
+#define bf_reg_r15(ctx) ((ctx)->uc_mcontext.gregs[REG_R15])
+#define BF_CALL_FRAME 8
+typedef ucontext_t bf_cpu_context;
+#elif defined __APPLE__
+#define bf_reg_rip(ctx) ((ctx)->uc_mcontext->__ss.__rip)
+#define bf_reg_rsp(ctx) ((ctx)->uc_mcontext->__ss.__rsp)
+#define bf_reg_arg(ctx) ((ctx)->uc_mcontext->__ss.__rdi)
+#define bf_reg_arg2(ctx) ((ctx)->uc_mcontext->__ss.__rsi)
+#define bf_reg_arg3(ctx) ((ctx)->uc_mcontext->__ss.__rdx)
+#define bf_reg_r12(ctx) ((ctx)->uc_mcontext->__ss.__r12)
+#define bf_reg_r15(ctx) ((ctx)->uc_mcontext->__ss.__r15)
+#define BF_CALL_FRAME 8
+typedef ucontext_t bf_cpu_context;
+#else
+#define bf_reg_rip(ctx) ((ctx)->uc_mcontext.mc_rip)
+#define bf_reg_rsp(ctx) ((ctx)->uc_mcontext.mc_rsp)
+#define bf_reg_arg(ctx) ((ctx)->uc_mcontext.mc_rdi)
+#define bf_reg_arg2(ctx) ((ctx)->uc_mcontext.mc_rsi)
+#define bf_reg_arg3(ctx) ((ctx)->uc_mcontext.mc_rdx)
+#define bf_reg_r12(ctx) ((ctx)->uc_mcontext.mc_r12)
+#define bf_reg_r15(ctx) ((ctx)->uc_mcontext.mc_r15)
+#define BF_CALL_FRAME 8
+typedef ucontext_t bf_cpu_context;
+#endif
+
+static int bf_guard_commit(unsigned char* p)
+{
+    if (p < bf_guard.grow_begin || p >= bf_guard.grow_end)
+        return 0;
+
+    size_t off = (size_t)(p - bf_guard.grow_begin) / BF_GUARD_COMMIT_SIZE * BF_GUARD_COMMIT_SIZE;
+    size_t size = (size_t)(bf_guard.grow_end - bf_guard.grow_begin) - off;
+    if (size > BF_GUARD_COMMIT_SIZE)
+        size = BF_GUARD_COMMIT_SIZE;
+#ifdef _WIN32
+    return VirtualAlloc(bf_guard.grow_begin + off, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    return mprotect(bf_guard.grow_begin + off, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+static int bf_guard_redirect(bf_cpu_context* cpu, void* addr)
+{
+    unsigned char* p = addr;
+    if (p < bf_guard.begin || p >= bf_guard.end)
+        return 0;
+    // faulting instruction is executed again with the page committed
+    if (bf_guard_commit(p))
+        return 1;
+
+    bf_runtime_context* ctx = (bf_runtime_context*)(uintptr_t)bf_reg_r12(cpu);
+    ctx->output_cur = (unsigned char*)(uintptr_t)bf_reg_r15(cpu);
+
+    bf_reg_rsp(cpu) -= BF_CALL_FRAME;
+    *(uint64_t*)(uintptr_t)bf_reg_rsp(cpu) = 0;
+    bf_reg_arg(cpu) = bf_reg_r12(cpu);
+    bf_reg_arg2(cpu) = (uintptr_t)p;
+    bf_reg_arg3(cpu) = bf_reg_rip(cpu);
+    bf_reg_rip(cpu) = (uintptr_t)ctx->out_of_bounds;
+    return 1;
+}
+
+#ifdef _WIN32
+
+static PVOID bf_guard_handle;
+
+static LONG CALLBACK bf_guard_handler(EXCEPTION_POINTERS* info)
+{
+    EXCEPTION_RECORD* rec = info->ExceptionRecord;
+    if (rec->ExceptionCode == EXCEPTION_ACCESS_VIOLATION && rec->NumberParameters >= 2 &&
+        bf_guard_redirect(info->ContextRecord, (void*)rec->ExceptionInformation[1]))
+        return EXCEPTION_CONTINUE_EXECUTION;
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+
+static SRWLOCK bf_guard_lock = SRWLOCK_INIT;
+
+void bf_guard_install(const bf_guard_region* region)
+{
+    AcquireSRWLockExclusive(&bf_guard_lock);
+    if (bf_guard_count == 0)
+    {
+        bf_guard_handle = AddVectoredExceptionHandler(1, bf_guard_handler);
+        if (!bf_guard_handle)
+        {
+            ReleaseSRWLockExclusive(&bf_guard_lock);
+            bf_error("couldn't install exception handler");
+        }
+    }
+    bf_guard_count += 1;
+    ReleaseSRWLockExclusive(&bf_guard_lock);
+    bf_guard = *region;
+}
+
+void bf_guard_uninstall(void)
+{
+    memset(&bf_guard, 0, sizeof(bf_guard));
+    AcquireSRWLockExclusive(&bf_guard_lock);
+    if (--bf_guard_count == 0)
+        RemoveVectoredExceptionHandler(bf_guard_handle);
+    ReleaseSRWLockExclusive(&bf_guard_lock);
+}
+
+#else
+
+static struct sigaction bf_guard_old_segv;
+static struct sigaction bf_guard_old_bus;
+
+static void bf_guard_handler(int sig, siginfo_t* info, void* ucontext)
+{
+    if (bf_guard_redirect(ucontext, info->si_addr))
+        return;
+
+    // not caused by compiled code, restore the previous handler and let
+    // the instruction fault again
+    sigaction(sig, (sig == SIGSEGV) ? &bf_guard_old_segv : &bf_guard_old_bus, NULL);
+}
+
+static pthread_mutex_t bf_guard_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void bf_guard_install(const bf_guard_region* region)
+{
+    pthread_mutex_lock(&bf_guard_lock);
+    if (bf_guard_count == 0)
+    {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_sigaction = bf_guard_handler;
+        sa.sa_flags = SA_SIGINFO;
+        sigemptyset(&sa.sa_mask);
+        if (sigaction(SIGSEGV, &sa, &bf_guard_old_segv) != 0 || sigaction(SIGBUS, &sa, &bf_guard_old_bus) != 0)
+        {
+            pthread_mutex_unlock(&bf_guard_lock);
+            bf_error("couldn't install signal handler");
+        }
+    }
+    bf_guard_count += 1;
+    pthread_mutex_unlock(&bf_guard_lock);
+    bf_guard = *region;
+}
+
+void bf_guard_uninstall(void)
+{
+    memset(&bf_guard, 0, sizeof(bf_guard));
+    pthread_mutex_lock(&bf_guard_lock);
+    if (--bf_guard_count == 0)
+    {
+        sigaction(SIGSEGV, &bf_guard_old_segv, NULL);
+        sigaction(SIGBUS, &bf_guard_old_bus, NULL);
+    }
+    pthread_mutex_unlock(&bf_guard_lock);
+}
+
+#endif
+
+#else
+
+void bf_guard_install(const bf_guard_region* region)
+{
+    (void)region;
+    bf_error("guard pages are not supported on this platform");
+}
+
+void bf_guard_uninstall(void) {}
+
+#endif
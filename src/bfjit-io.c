@@ -1,26 +1,35 @@
 #include <stddef.h>
+#include <stdint.h>
 #ifdef _WIN32
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 #else
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #endif
 
 #include "bfjit.h"
 #include "bfjit-io.h"
 
-static bf_file bf_open_file_impl(const char* filename, int write)
+// mode 0 is read, 1 is write and 2 is read and execute
+static bf_file bf_try_open_file_impl(const char* filename, int mode)
 {
 #ifdef _WIN32
-    bf_file f = CreateFileA(filename, (write ? GENERIC_WRITE : GENERIC_READ),
-                            FILE_SHARE_READ, NULL, (write ? CREATE_ALWAYS : OPEN_EXISTING),
-                            FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    static const DWORD access[] = {GENERIC_READ, GENERIC_WRITE, GENERIC_READ | GENERIC_EXECUTE};
+    return CreateFileA(filename, access[mode], FILE_SHARE_READ | (mode == 2 ? FILE_SHARE_DELETE : 0), NULL,
+                       (mode == 1 ? CREATE_ALWAYS : OPEN_EXISTING), FILE_FLAG_SEQUENTIAL_SCAN, NULL);
 #else
-    bf_file f = open(filename, (write ? (O_WRONLY | O_CREAT | O_TRUNC) : O_RDONLY), 0666);
+    return open(filename, (mode == 1 ? (O_WRONLY | O_CREAT | O_TRUNC) : O_RDONLY), 0666);
 #endif
-    if (f != (bf_file)-1)
+}
+
+static bf_file bf_open_file_impl(const char* filename, int mode)
+{
+    bf_file f = bf_try_open_file_impl(filename, mode);
+    if (f != BF_INVALID_FILE)
         return f;
     bf_error("couldn't open file '%s'", filename);
 }
@@ -35,6 +44,20 @@ bf_file bf_open_file_write(const char* filename)
     return bf_open_file_impl(filename, 1);
 }
 
+bf_file bf_try_open_file_exec(const char* filename)
+{
+    return bf_try_open_file_impl(filename, 2);
+}
+
+bf_file bf_stdin_file(void)
+{
+#ifdef _WIN32
+    return GetStdHandle(STD_INPUT_HANDLE);
+#else
+    return STDIN_FILENO;
+#endif
+}
+
 void bf_close_file(bf_file file)
 {
 #ifdef _WIN32
@@ -50,6 +73,9 @@ size_t bf_read_file(bf_file file, void* buff, size_t size)
     DWORD read;
     if (ReadFile(file, buff, (DWORD)size, &read, NULL))
         return read;
+    // write end of a pipe was closed
+    if (GetLastError() == ERROR_BROKEN_PIPE)
+        return 0;
 #else
     ssize_t result = read(file, buff, size);
     if (result != -1)
@@ -78,3 +104,52 @@ void bf_save_to_file(const char* filename, void* data, size_t size)
     bf_write_file(f, data, size);
     bf_close_file(f);
 }
+
+static void* bf_map_file_impl(bf_file file, size_t* size, int exec)
+{
+#ifdef _WIN32
+    LARGE_INTEGER file_size;
+    if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &file_size) ||
+        file_size.QuadPart == 0 || (unsigned long long)file_size.QuadPart > SIZE_MAX)
+        return NULL;
+    HANDLE mapping = CreateFileMappingA(file, NULL, (exec ? PAGE_EXECUTE_READ : PAGE_READONLY), 0, 0, NULL);
+    if (mapping == NULL)
+        return NULL;
+    void* mem = MapViewOfFile(mapping, FILE_MAP_READ | (exec ? FILE_MAP_EXECUTE : 0), 0, 0, 0);
+    CloseHandle(mapping);
+    if (mem == NULL)
+        return NULL;
+    *size = (size_t)file_size.QuadPart;
+    return mem;
+#else
+    struct stat st;
+    if (fstat(file, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0 ||
+        (unsigned long long)st.st_size > SIZE_MAX)
+        return NULL;
+    void* mem = mmap(NULL, (size_t)st.st_size, PROT_READ | (exec ? PROT_EXEC : 0), MAP_PRIVATE, file, 0);
+    if (mem == MAP_FAILED)
+        return NULL;
+    *size = (size_t)st.st_size;
+    return mem;
+#endif
+}
+
+void* bf_map_file(bf_file file, size_t* size)
+{
+    return bf_map_file_impl(file, size, 0);
+}
+
+void* bf_map_file_exec(bf_file file, size_t* size)
+{
+    return bf_map_file_impl(file, size, 1);
+}
+
+void bf_unmap_file(void* mem, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(mem);
+#else
+    munmap(mem, size);
+#endif
+}
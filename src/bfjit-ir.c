@@ -0,0 +1,248 @@
+#include <assert.h>
+#include <string.h>
+
+#include "bfjit.h"
+#include "bfjit-ir.h"
+#include "bfjit-memory.h"
+#include "bfjit-source.h"
+
+void bf_ir_init(bf_ir* ir)
+{
+    ir->ops = NULL;
+    ir->size = 0;
+    ir->cap = 0;
+    ir->loops = NULL;
+    ir->loops_size = 0;
+    ir->loops_cap = 0;
+    ir->data = NULL;
+    ir->data_size = 0;
+    ir->data_cap = 0;
+    ir->lines = NULL;
+    ir->lines_size = 0;
+    ir->lines_cap = 0;
+}
+
+void bf_ir_free(bf_ir* ir)
+{
+    bf_free(ir->ops);
+    bf_free(ir->loops);
+    bf_free(ir->data);
+    bf_free(ir->lines);
+    bf_ir_init(ir);
+}
+
+void bf_ir_swap(bf_ir* a, bf_ir* b)
+{
+    bf_ir tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+void bf_ir_push_op(bf_ir* ir, const bf_ir_op* op)
+{
+    if (ir->size == ir->cap)
+    {
+        ir->cap = (ir->cap == 0) ? 1024 : (ir->cap * 2);
+        ir->ops = bf_realloc(ir->ops, ir->cap * sizeof(bf_ir_op));
+    }
+    ir->ops[ir->size++] = *op;
+}
+
+size_t bf_ir_push(bf_ir* ir, bf_ir_kind kind, int32_t off, int32_t val)
+{
+    bf_ir_op op;
+    op.kind = (uint8_t)kind;
+    op.flags = 0;
+    op.off = off;
+    op.val = val;
+    op.link = 0;
+    op.src = BF_IR_NO_SRC;
+    bf_ir_push_op(ir, &op);
+    return ir->size - 1;
+}
+
+static void bf_ir_reserve_data(bf_ir* ir, size_t count)
+{
+    if (ir->data_size + count > ir->data_cap)
+    {
+        ir->data_cap = (ir->data_cap == 0) ? 1024 : (ir->data_cap * 2);
+        if (ir->data_cap < ir->data_size + count)
+            ir->data_cap = ir->data_size + count;
+        ir->data = bf_realloc(ir->data, ir->data_cap);
+    }
+}
+
+size_t bf_ir_push_data(bf_ir* ir, unsigned char value, size_t count)
+{
+    bf_ir_reserve_data(ir, count);
+    memset(ir->data + ir->data_size, value, count);
+    ir->data_size += count;
+    return ir->data_size - count;
+}
+
+size_t bf_ir_push_bytes(bf_ir* ir, const unsigned char* bytes, size_t count)
+{
+    bf_ir_reserve_data(ir, count);
+    if (count != 0)
+        memcpy(ir->data + ir->data_size, bytes, count);
+    ir->data_size += count;
+    return ir->data_size - count;
+}
+
+static void bf_ir_push_loop(bf_ir* ir, uint32_t begin, int32_t parent, uint32_t depth)
+{
+    if (ir->loops_size == ir->loops_cap)
+    {
+        ir->loops_cap = (ir->loops_cap == 0) ? 64 : (ir->loops_cap * 2);
+        ir->loops = bf_realloc(ir->loops, ir->loops_cap * sizeof(bf_ir_loop));
+    }
+    bf_ir_loop l;
+    l.begin = begin;
+    l.end = begin;
+    l.parent = parent;
+    l.depth = depth;
+    l.innermost = 1;
+    ir->loops[ir->loops_size++] = l;
+}
+
+void bf_ir_link(bf_ir* ir)
+{
+    // loops are numbered in order of their opening ops, so the chain of
+    // 'parent' indices doubles as the stack of currently open loops
+    int32_t open = -1;
+    ir->loops_size = 0;
+
+    for (size_t i = 0; i != ir->size; ++i)
+    {
+        bf_ir_op* op = &ir->ops[i];
+        if (op->kind == BF_IR_LOOP || op->kind == BF_IR_IF)
+        {
+            uint32_t depth = 0;
+            if (open != -1)
+            {
+                ir->loops[open].innermost = 0;
+                depth = ir->loops[open].depth + 1;
+            }
+            bf_ir_push_loop(ir, (uint32_t)i, open, depth);
+            open = (int32_t)ir->loops_size - 1;
+        }
+        else if (op->kind == BF_IR_END)
+        {
+            assert(open != -1);
+            bf_ir_loop* l = &ir->loops[open];
+            l->end = (uint32_t)i;
+            op->link = l->begin;
+            ir->ops[l->begin].link = (uint32_t)i;
+            open = l->parent;
+        }
+    }
+    assert(open == -1);
+}
+
+void bf_ir_init_pass(bf_ir* out, bf_ir* ir)
+{
+    bf_ir_init(out);
+    out->data = ir->data;
+    out->data_size = ir->data_size;
+    out->data_cap = ir->data_cap;
+    ir->data = NULL;
+    ir->data_size = 0;
+    ir->data_cap = 0;
+    out->lines = ir->lines;
+    out->lines_size = ir->lines_size;
+    out->lines_cap = ir->lines_cap;
+    ir->lines = NULL;
+    ir->lines_size = 0;
+    ir->lines_cap = 0;
+}
+
+void bf_ir_replace(bf_ir* ir, bf_ir* out)
+{
+    bf_ir_link(out);
+    bf_ir_swap(ir, out);
+    bf_ir_free(out);
+}
+
+static void bf_ir_push_src(bf_ir* ir, bf_ir_kind kind, int32_t val, uint32_t src)
+{
+    size_t i = bf_ir_push(ir, kind, 0, val);
+    ir->ops[i].src = src;
+}
+
+static void bf_ir_push_merged(bf_ir* ir, bf_ir_kind kind, int32_t val, uint32_t src)
+{
+    if (ir->size != 0 && ir->ops[ir->size - 1].kind == kind)
+    {
+        bf_ir_op* last = &ir->ops[ir->size - 1];
+        last->val += val;
+        if (last->val == 0 || (kind == BF_IR_ADD && (last->val & 0xFF) == 0))
+            ir->size -= 1;
+        return;
+    }
+    bf_ir_push_src(ir, kind, val, src);
+}
+
+void bf_ir_parse_file(const char* filename, bf_ir* ir)
+{
+    bf_source source;
+    bf_source_load(&source, filename);
+
+    ir->size = 0;
+    for (size_t i = 0; i != source.size; ++i)
+    {
+        uint32_t src = source.offsets[i];
+        switch (source.commands[i])
+        {
+        case '-':
+            bf_ir_push_merged(ir, BF_IR_ADD, -1, src);
+            break;
+        case '+':
+            bf_ir_push_merged(ir, BF_IR_ADD, 1, src);
+            break;
+        case '<':
+            bf_ir_push_merged(ir, BF_IR_MOVE, -1, src);
+            break;
+        case '>':
+            bf_ir_push_merged(ir, BF_IR_MOVE, 1, src);
+            break;
+        case '.':
+            bf_ir_push_merged(ir, BF_IR_OUTPUT, 1, src);
+            break;
+        case ',':
+            bf_ir_push_src(ir, BF_IR_INPUT, 0, src);
+            break;
+        case '[':
+            bf_ir_push_src(ir, BF_IR_LOOP, 0, src);
+            break;
+        case ']':
+            bf_ir_push_src(ir, BF_IR_END, 0, src);
+            break;
+        }
+    }
+
+    // the ir takes over the lines
+    bf_free(ir->lines);
+    ir->lines = source.lines;
+    ir->lines_size = source.lines_size;
+    ir->lines_cap = source.lines_cap;
+    source.lines = NULL;
+    bf_source_free(&source);
+    bf_ir_link(ir);
+}
+
+void bf_ir_source_position(const bf_ir* ir, uint32_t src, uint32_t* line, uint32_t* col)
+{
+    // lines starting at or before 'src'
+    size_t lo = 0;
+    size_t hi = ir->lines_size;
+    while (lo != hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (ir->lines[mid] <= src)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *line = (uint32_t)lo + 1;
+    *col = src - (lo == 0 ? 0 : ir->lines[lo - 1]) + 1;
+}
@@ -5,6 +5,7 @@
 #include <Windows.h>
 #else
 #include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 #include "bfjit.h"
@@ -47,6 +48,43 @@ void* bf_virtual_alloc(size_t size)
     bf_alloc_error();
 }
 
+size_t bf_page_size(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+void* bf_virtual_reserve(size_t size)
+{
+#ifdef _WIN32
+    void* mem = VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+    if (mem)
+        return mem;
+#else
+    void* mem = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem != MAP_FAILED)
+        return mem;
+#endif
+    bf_alloc_error();
+}
+
+void bf_virtual_commit(void* mem, size_t size)
+{
+#ifdef _WIN32
+    if (VirtualAlloc(mem, size, MEM_COMMIT, PAGE_READWRITE))
+        return;
+#else
+    if (mprotect(mem, size, PROT_READ | PROT_WRITE) != -1)
+        return;
+#endif
+    bf_alloc_error();
+}
+
 void bf_virtual_make_exe(void* mem, size_t size)
 {
 #ifdef _WIN32
@@ -0,0 +1,1735 @@
+#include <assert.h>
+#include <string.h>
+
+#include "bfjit.h"
+#include "bfjit-bitops.h"
+#include "bfjit-ir.h"
+#include "bfjit-memory.h"
+
+static int32_t bf_wrap_add(int32_t val)
+{
+    val &= 0xFF;
+    return val >= 128 ? val - 256 : val;
+}
+
+static int bf_is_straight_op(const bf_ir_op* op)
+{
+    return op->kind == BF_IR_ADD || op->kind == BF_IR_SET || op->kind == BF_IR_MOVE;
+}
+
+static int bf_is_io_op(const bf_ir_op* op)
+{
+    return op->kind == BF_IR_INPUT || op->kind == BF_IR_OUTPUT || op->kind == BF_IR_WRITE;
+}
+
+/*
+ *  Straight-line code segment: pending cell updates relative to the pointer
+ *  at the beginning of the segment, and the net pointer movement.
+ */
+
+typedef struct {
+    int32_t off;
+    int32_t val;
+    uint8_t kind;
+    uint32_t src;       // of the last SET, or the first ADD after it
+} bf_pending_op;
+
+typedef struct {
+    bf_pending_op* ops;
+    size_t size;
+    size_t cap;
+    int32_t offset;
+    uint32_t move_src;  // of the last movement
+} bf_segment;
+
+static void bf_segment_clear(bf_segment* seg)
+{
+    seg->size = 0;
+    seg->offset = 0;
+    seg->move_src = BF_IR_NO_SRC;
+}
+
+static void bf_segment_add(bf_segment* seg, bf_ir_kind kind, int32_t off, int32_t val, uint32_t src)
+{
+    for (size_t i = 0; i != seg->size; ++i)
+    {
+        bf_pending_op* p = &seg->ops[i];
+        if (p->off == off)
+        {
+            if (kind == BF_IR_SET)
+            {
+                p->kind = BF_IR_SET;
+                p->val = val;
+                p->src = src;
+            }
+            else
+            {
+                p->val = bf_wrap_add(p->val + val);
+            }
+            return;
+        }
+    }
+
+    if (seg->size == seg->cap)
+    {
+        seg->cap = (seg->cap == 0) ? 16 : (seg->cap * 2);
+        seg->ops = bf_realloc(seg->ops, seg->cap * sizeof(bf_pending_op));
+    }
+    bf_pending_op p;
+    p.off = off;
+    p.val = (kind == BF_IR_SET) ? val : bf_wrap_add(val);
+    p.kind = (uint8_t)kind;
+    p.src = src;
+    seg->ops[seg->size++] = p;
+}
+
+static void bf_segment_feed(bf_segment* seg, const bf_ir_op* op)
+{
+    if (op->kind == BF_IR_MOVE)
+    {
+        seg->offset += op->val;
+        seg->move_src = op->src;
+    }
+    else
+        bf_segment_add(seg, (bf_ir_kind)op->kind, seg->offset + op->off, op->val, op->src);
+}
+
+static void bf_segment_emit_op(bf_ir* out, const bf_pending_op* p, int32_t off)
+{
+    size_t i;
+    if (p->kind == BF_IR_SET)
+        i = bf_ir_push(out, BF_IR_SET, off, p->val & 0xFF);
+    else if (p->val != 0)
+        i = bf_ir_push(out, BF_IR_ADD, off, p->val);
+    else
+        return;
+    out->ops[i].src = p->src;
+}
+
+static void bf_segment_flush(bf_segment* seg, bf_ir* out)
+{
+    // update of the current cell goes last, and update of the cell under
+    // the final pointer is delayed past the move, so that the encoder can
+    // apply both of them to the cached value
+    const bf_pending_op* delayed = NULL;
+    const bf_pending_op* inplace = NULL;
+    for (size_t i = 0; i != seg->size; ++i)
+    {
+        if (seg->offset != 0 && seg->ops[i].off == seg->offset)
+            delayed = &seg->ops[i];
+        else if (seg->ops[i].off == 0)
+            inplace = &seg->ops[i];
+        else
+            bf_segment_emit_op(out, &seg->ops[i], seg->ops[i].off);
+    }
+    if (inplace)
+        bf_segment_emit_op(out, inplace, 0);
+
+    if (seg->offset != 0)
+    {
+        size_t i = bf_ir_push(out, BF_IR_MOVE, 0, seg->offset);
+        out->ops[i].src = seg->move_src;
+    }
+    if (delayed)
+        bf_segment_emit_op(out, delayed, 0);
+
+    bf_segment_clear(seg);
+}
+
+static const bf_pending_op* bf_segment_find(const bf_segment* seg, int32_t off)
+{
+    for (size_t i = 0; i != seg->size; ++i)
+        if (seg->ops[i].off == off && (seg->ops[i].kind == BF_IR_SET || seg->ops[i].val != 0))
+            return &seg->ops[i];
+    return NULL;
+}
+
+/*
+ *  Pass: fold runs of additions and pointer movements into offset operations.
+ */
+
+static void bf_pass_fold_offsets(bf_ir* ir, const bf_ir_options* opts)
+{
+    (void)opts;
+    bf_ir out;
+    bf_ir_init_pass(&out, ir);
+    bf_segment seg = {NULL, 0, 0, 0, BF_IR_NO_SRC};
+
+    for (size_t i = 0; i != ir->size; ++i)
+    {
+        const bf_ir_op* op = &ir->ops[i];
+        if (bf_is_straight_op(op))
+        {
+            bf_segment_feed(&seg, op);
+        }
+        else
+        {
+            bf_segment_flush(&seg, &out);
+            bf_ir_push_op(&out, op);
+        }
+    }
+    bf_segment_flush(&seg, &out);
+
+    bf_free(seg.ops);
+    bf_ir_replace(ir, &out);
+}
+
+/*
+ *  Pass: replace simple innermost loops with clear, scan and multiply operations,
+ *  and balanced loops around multiplications with products.
+ */
+
+// inverse of an odd value modulo 256
+static int32_t bf_inverse(int32_t val)
+{
+    // each step doubles the number of correct low bits, starting with three
+    uint32_t x = (uint32_t)val;
+    uint32_t inv = x;
+    for (int i = 0; i != 2; ++i)
+        inv *= 2 - x * inv;
+    return (int32_t)(inv & 0xFF);
+}
+
+// ops replacing a loop keep the position of its '[', except for the clear after a multiplication
+// and the loop left to step counters the original one never ends for
+static void bf_push_idiom(bf_ir* out, const bf_ir_op* begin, bf_ir_kind kind, int32_t off, int32_t val)
+{
+    size_t i = bf_ir_push(out, kind, off, val);
+    out->ops[i].src = begin->src;
+}
+
+static void bf_emit_loop_idiom(bf_ir* out, const bf_ir* ir, const bf_ir_loop* loop, bf_segment* seg)
+{
+    const bf_ir_op* begin = &ir->ops[loop->begin];
+    const bf_ir_op* end = &ir->ops[loop->end];
+
+    bf_segment_clear(seg);
+    for (const bf_ir_op* op = begin + 1; op != end; ++op)
+    {
+        if (!bf_is_straight_op(op))
+            goto not_optimized;
+        bf_segment_feed(seg, op);
+    }
+
+    const bf_pending_op* inplace = bf_segment_find(seg, 0);
+    size_t others = seg->size - (inplace != NULL);
+    for (size_t i = 0; i != seg->size; ++i)
+        if (seg->ops[i].kind == BF_IR_ADD && seg->ops[i].val == 0)
+            --others;
+
+    if (inplace == NULL && seg->offset == 0)
+    {
+        // infinite loop
+        // lets make it loop infinitely even faster by removing side effects
+        bf_ir_push_op(out, begin);
+        bf_ir_push_op(out, end);
+        return;
+    }
+    if (inplace == NULL && others == 0)
+    {
+        bf_push_idiom(out, begin, BF_IR_SCAN, 0, seg->offset);
+        return;
+    }
+    if (seg->offset != 0 || inplace == NULL || inplace->kind != BF_IR_ADD)
+        goto not_optimized;
+
+    /*  The counter steps by 'step' = 2^k * odd, the loop ends after n passes
+     *  with cell + n * step = 0 (mod 256), which has a solution only for cells
+     *  divisible by 2^k: n = (cell / 2^k) * inverse(-odd) (mod 2^(8 - k)).
+     *  Other cells get val * n added, that is cell * (val / 2^k) * inverse(-odd)
+     *  as long as val is divisible by 2^k too. Cells the loop never ends for are
+     *  left to a loop stepping the counter alone, which doesn't end either.
+     */
+    int32_t step = inplace->val;
+    unsigned shift = bf_ctz((uint32_t)step);
+    int32_t inverse = bf_inverse(-step / (1 << shift));
+    if (others == 0 && shift == 0)
+    {
+        bf_push_idiom(out, begin, BF_IR_SET, 0, 0);
+        return;
+    }
+    if (others == 0)
+        goto not_optimized;
+    for (size_t i = 0; i != seg->size; ++i)
+        if (seg->ops[i].kind != BF_IR_ADD || seg->ops[i].val % (1 << shift) != 0)
+            goto not_optimized;
+
+    bf_push_idiom(out, begin, BF_IR_IF, 0, 0);
+    for (size_t i = 0; i != seg->size; ++i)
+        if (seg->ops[i].off != 0 && seg->ops[i].val != 0)
+            bf_push_idiom(out, begin, BF_IR_MUL, seg->ops[i].off,
+                          bf_wrap_add(seg->ops[i].val / (1 << shift) * inverse));
+    bf_ir_push(out, BF_IR_END, 0, 0);
+    if (shift == 0)
+    {
+        bf_ir_push(out, BF_IR_SET, 0, 0);
+    }
+    else
+    {
+        bf_ir_push(out, BF_IR_LOOP, 0, 0);
+        bf_ir_push(out, BF_IR_ADD, 0, step);
+        bf_ir_push(out, BF_IR_END, 0, 0);
+    }
+    return;
+
+not_optimized:
+    for (const bf_ir_op* op = begin; op != end + 1; ++op)
+        bf_ir_push_op(out, op);
+}
+
+/*
+ *  Balanced loops whose nested loops turned into multiplications update
+ *  cells by linear functions of the cells they start with. When a pass adds
+ *  the same multiple of unchanged cells to the others, the loop collapses
+ *  into products with the pass count, which is the counter times the
+ *  inverse of its step. Cells the body sets to a constant are often reused
+ *  by the next pass, so the first pass is kept as it is and the rest of the
+ *  passes start with them known.
+ */
+
+// cells a collapsed loop may address
+#define BF_POLY_MAX_CELLS 16
+
+// value of a cell after a pass, base + sum of coef[i] * (cell i at the start of the pass)
+typedef struct {
+    int32_t off;
+    uint8_t coef[BF_POLY_MAX_CELLS];
+    uint8_t base;
+} bf_poly_cell;
+
+typedef struct {
+    bf_poly_cell cells[BF_POLY_MAX_CELLS];
+    size_t size;
+} bf_poly;
+
+static bf_poly_cell* bf_poly_get(bf_poly* poly, int32_t off)
+{
+    for (size_t i = 0; i != poly->size; ++i)
+        if (poly->cells[i].off == off)
+            return &poly->cells[i];
+    if (poly->size == BF_POLY_MAX_CELLS)
+        return NULL;
+    bf_poly_cell* c = &poly->cells[poly->size];
+    memset(c, 0, sizeof(*c));
+    c->off = off;
+    c->coef[poly->size++] = 1;
+    return c;
+}
+
+// cell i after the pass is the one it started with
+static int bf_poly_unchanged(const bf_poly* poly, size_t i)
+{
+    for (size_t j = 0; j != poly->size; ++j)
+        if (poly->cells[i].coef[j] != (i == j))
+            return 0;
+    return poly->cells[i].base == 0;
+}
+
+// returns 0 if the body isn't made of linear updates or leaves the pointer elsewhere
+static int bf_poly_eval(bf_poly* poly, const bf_ir_op* body, size_t size)
+{
+    poly->size = 0;
+    bf_poly_get(poly, 0);
+    int32_t pos = 0;
+    int in_if = 0;
+    for (size_t i = 0; i != size; ++i)
+    {
+        const bf_ir_op* op = &body[i];
+        bf_poly_cell* c = NULL;
+        switch (op->kind)
+        {
+        case BF_IR_MOVE:
+            if (in_if)
+                return 0;
+            pos += op->val;
+            continue;
+        case BF_IR_IF:
+            // multiplications by a zero cell do nothing, so ifs around them don't matter
+            if (in_if)
+                return 0;
+            in_if = 1;
+            continue;
+        case BF_IR_END:
+            in_if = 0;
+            continue;
+        case BF_IR_ADD:
+        case BF_IR_SET:
+        case BF_IR_MUL:
+            if (in_if != (op->kind == BF_IR_MUL) || !(c = bf_poly_get(poly, pos + op->off)))
+                return 0;
+            break;
+        default:
+            return 0;
+        }
+
+        if (op->kind == BF_IR_ADD)
+        {
+            c->base = (uint8_t)(c->base + op->val);
+        }
+        else if (op->kind == BF_IR_SET)
+        {
+            memset(c->coef, 0, sizeof(c->coef));
+            c->base = (uint8_t)op->val;
+        }
+        else
+        {
+            const bf_poly_cell* f = bf_poly_get(poly, pos);
+            if (!f)
+                return 0;
+            for (size_t j = 0; j != poly->size; ++j)
+                c->coef[j] = (uint8_t)(c->coef[j] + f->coef[j] * op->val);
+            c->base = (uint8_t)(c->base + f->base * op->val);
+        }
+    }
+    return pos == 0;
+}
+
+// replaces the loop that starts at out->ops[begin] and ends with the last op
+static void bf_collapse_loop(bf_ir* out, size_t begin)
+{
+    bf_poly poly;
+    const bf_ir_op* body = &out->ops[begin + 1];
+    size_t body_size = out->size - begin - 2;
+    if (!bf_poly_eval(&poly, body, body_size))
+        return;
+
+    // the counter only steps by an odd value, so that every cell ends the loop
+    const bf_poly_cell* counter = &poly.cells[0];
+    if ((counter->base & 1) == 0 || counter->coef[0] != 1)
+        return;
+    for (size_t i = 1; i != poly.size; ++i)
+        if (counter->coef[i] != 0)
+            return;
+    int32_t inverse = bf_inverse(-(int32_t)counter->base);
+
+    // cells set to constants are known after the first pass
+    int peel = 0;
+    int set[BF_POLY_MAX_CELLS] = {0};
+    for (size_t i = 1; i != poly.size; ++i)
+    {
+        const bf_poly_cell* c = &poly.cells[i];
+        set[i] = 1;
+        for (size_t j = 0; j != poly.size; ++j)
+            if (c->coef[j] != 0)
+                set[i] = 0;
+    }
+    for (size_t i = 1; i != poly.size; ++i)
+    {
+        bf_poly_cell* c = &poly.cells[i];
+        for (size_t j = 1; j != poly.size; ++j)
+        {
+            if (!set[j] || c->coef[j] == 0)
+                continue;
+            c->base = (uint8_t)(c->base + c->coef[j] * poly.cells[j].base);
+            c->coef[j] = 0;
+            if (!set[i])
+                peel = 1;
+        }
+    }
+
+    // the rest of the cells have to add multiples of unchanged cells to themselves
+    for (size_t i = 1; i != poly.size; ++i)
+    {
+        const bf_poly_cell* c = &poly.cells[i];
+        if (set[i] || bf_poly_unchanged(&poly, i))
+            continue;
+        if (c->coef[i] != 1 || c->coef[0] != 0)
+            return;
+        for (size_t j = 1; j != poly.size; ++j)
+            if (j != i && c->coef[j] != 0 && ((uint8_t)(c->coef[j] * inverse) != 1 || !bf_poly_unchanged(&poly, j)))
+                return;
+    }
+
+    bf_ir_op loop = out->ops[begin];
+    bf_ir_op* peeled = NULL;
+    if (peel)
+    {
+        peeled = bf_realloc(NULL, body_size * sizeof(bf_ir_op));
+        memcpy(peeled, body, body_size * sizeof(bf_ir_op));
+    }
+    // the first pass changes the counter, which the body of an if can't do,
+    // so the peeled body goes into a loop that ends after it
+    out->size = begin;
+    bf_push_idiom(out, &loop, peel ? BF_IR_LOOP : BF_IR_IF, 0, 0);
+    for (size_t i = 0; i != body_size && peel; ++i)
+        bf_ir_push_op(out, &peeled[i]);
+    for (size_t i = 1; i != poly.size; ++i)
+    {
+        const bf_poly_cell* c = &poly.cells[i];
+        if (set[i])
+        {
+            if (!peel)
+                bf_push_idiom(out, &loop, BF_IR_SET, c->off, c->base);
+            continue;
+        }
+        if (bf_poly_unchanged(&poly, i))
+            continue;
+        if (c->base != 0)
+            bf_push_idiom(out, &loop, BF_IR_MUL, c->off, bf_wrap_add(c->base * inverse));
+        for (size_t j = 1; j != poly.size; ++j)
+            if (j != i && c->coef[j] != 0)
+                bf_push_idiom(out, &loop, BF_IR_PRODUCT, c->off, poly.cells[j].off);
+    }
+    if (peel)
+        bf_ir_push(out, BF_IR_SET, 0, 0);
+    bf_ir_push(out, BF_IR_END, 0, 0);
+    if (!peel)
+        bf_ir_push(out, BF_IR_SET, 0, 0);
+    bf_free(peeled);
+}
+
+static void bf_pass_loop_idioms(bf_ir* ir, const bf_ir_options* opts)
+{
+    (void)opts;
+    bf_ir out;
+    bf_ir_init_pass(&out, ir);
+    bf_segment seg = {NULL, 0, 0, 0, BF_IR_NO_SRC};
+    size_t next_loop = 0;
+    // positions in 'out' of the enclosing loops
+    size_t* outer = bf_realloc(NULL, (ir->loops_size + 1) * sizeof(size_t));
+    size_t depth = 0;
+
+    for (size_t i = 0; i != ir->size; ++i)
+    {
+        const bf_ir_op* op = &ir->ops[i];
+        if (op->kind == BF_IR_LOOP || op->kind == BF_IR_IF)
+        {
+            const bf_ir_loop* loop = &ir->loops[next_loop++];
+            assert(loop->begin == i);
+            if (op->kind == BF_IR_LOOP && loop->innermost)
+            {
+                bf_emit_loop_idiom(&out, ir, loop, &seg);
+                i = loop->end;
+                continue;
+            }
+            outer[depth++] = (op->kind == BF_IR_LOOP) ? out.size : SIZE_MAX;
+        }
+        bf_ir_push_op(&out, op);
+        if (op->kind == BF_IR_END && outer[--depth] != SIZE_MAX)
+            bf_collapse_loop(&out, outer[depth]);
+    }
+
+    bf_free(outer);
+    bf_free(seg.ops);
+    bf_ir_replace(ir, &out);
+}
+
+/*
+ *  Pass: track known cell values, fold operations on them and drop loops
+ *  that are never entered. With 'track_tape' unset only the current cell
+ *  is tracked, otherwise knowledge about the whole tape survives pointer
+ *  movements and balanced loops.
+ */
+
+#define BF_KNOWN_MAX_CELLS 1024
+
+typedef struct {
+    int32_t off;
+    uint8_t value;
+    uint8_t known;
+} bf_known_cell;
+
+typedef struct {
+    bf_known_cell* cells;
+    size_t size;
+    size_t cap;
+    int rest_zero;      // cells without an entry are known to be zero
+    int nonzero;        // cell[0] is known to be non-zero
+    int32_t lo, hi;     // cells kept accesses have shown to be on the tape, none if lo > hi
+} bf_knowledge;
+
+typedef struct {
+    bf_knowledge state;
+    uint32_t end;
+    int unwrapped;
+} bf_known_frame;
+
+typedef struct {
+    int track_tape;
+    int rtc;
+    bf_knowledge state;
+    bf_known_frame* frames;
+    size_t frames_size;
+    size_t frames_cap;
+    int32_t* writes;
+    size_t writes_size;
+    size_t writes_cap;
+} bf_known_ctx;
+
+static bf_known_cell* bf_known_find(bf_knowledge* k, int32_t off)
+{
+    for (size_t i = 0; i != k->size; ++i)
+        if (k->cells[i].off == off)
+            return &k->cells[i];
+    return NULL;
+}
+
+static int bf_known_get(bf_knowledge* k, int32_t off, uint8_t* value)
+{
+    bf_known_cell* c = bf_known_find(k, off);
+    if (c)
+    {
+        *value = c->value;
+        return c->known;
+    }
+    *value = 0;
+    return k->rest_zero;
+}
+
+static void bf_known_forget_all(bf_knowledge* k)
+{
+    k->size = 0;
+    k->rest_zero = 0;
+    k->nonzero = 0;
+    k->lo = 1;
+    k->hi = 0;
+}
+
+static void bf_known_touch(bf_knowledge* k, int32_t off)
+{
+    if (k->lo > k->hi)
+    {
+        k->lo = off;
+        k->hi = off;
+    }
+    else if (off < k->lo)
+        k->lo = off;
+    else if (off > k->hi)
+        k->hi = off;
+}
+
+static void bf_known_put(bf_known_ctx* ctx, int32_t off, uint8_t value, uint8_t known)
+{
+    bf_knowledge* k = &ctx->state;
+    if (off == 0)
+        k->nonzero = known && value != 0;
+    if (!ctx->track_tape && off != 0)
+        return;
+
+    bf_known_cell* c = bf_known_find(k, off);
+    if (c)
+    {
+        c->value = value;
+        c->known = known;
+        return;
+    }
+    if (!known && !k->rest_zero)
+        return;
+    if (k->size == BF_KNOWN_MAX_CELLS)
+    {
+        bf_knowledge keep = *k;
+        bf_known_forget_all(k);
+        k->nonzero = keep.nonzero;
+        k->lo = keep.lo;
+        k->hi = keep.hi;
+        if (!known)
+            return;
+    }
+    if (k->size == k->cap)
+    {
+        k->cap = (k->cap == 0) ? 16 : (k->cap * 2);
+        k->cells = bf_realloc(k->cells, k->cap * sizeof(bf_known_cell));
+    }
+    bf_known_cell cell;
+    cell.off = off;
+    cell.value = value;
+    cell.known = known;
+    k->cells[k->size++] = cell;
+}
+
+static void bf_known_move(bf_known_ctx* ctx, int32_t delta)
+{
+    bf_knowledge* k = &ctx->state;
+    k->nonzero = 0;
+    k->lo -= delta;
+    k->hi -= delta;
+    if (!ctx->track_tape)
+    {
+        k->size = 0;
+        return;
+    }
+    for (size_t i = 0; i != k->size; ++i)
+        k->cells[i].off -= delta;
+}
+
+static void bf_known_copy(bf_knowledge* dst, const bf_knowledge* src)
+{
+    if (dst->cap < src->size)
+    {
+        dst->cap = src->size;
+        dst->cells = bf_realloc(dst->cells, dst->cap * sizeof(bf_known_cell));
+    }
+    if (src->size != 0)
+        memcpy(dst->cells, src->cells, src->size * sizeof(bf_known_cell));
+    dst->size = src->size;
+    dst->rest_zero = src->rest_zero;
+    dst->nonzero = src->nonzero;
+    dst->lo = src->lo;
+    dst->hi = src->hi;
+}
+
+// collects offsets of cells written by the body of a loop, returns 0 if
+// the pointer position at the end of an iteration is not known statically
+static int bf_known_collect_writes(bf_known_ctx* ctx, const bf_ir* ir, uint32_t begin, uint32_t end)
+{
+    int32_t cur = 0;
+    ctx->writes_size = 0;
+
+    for (uint32_t i = begin + 1; i != end; ++i)
+    {
+        const bf_ir_op* op = &ir->ops[i];
+        switch (op->kind)
+        {
+        case BF_IR_MOVE:
+            cur += op->val;
+            continue;
+        case BF_IR_SCAN:
+            return 0;
+        case BF_IR_LOOP:
+        {
+            // nested loops have to be balanced as well
+            int32_t inner = 0;
+            for (uint32_t j = i + 1; j != op->link; ++j)
+                if (ir->ops[j].kind == BF_IR_MOVE)
+                    inner += ir->ops[j].val;
+            if (inner != 0)
+                return 0;
+            continue;
+        }
+        case BF_IR_ADD:
+        case BF_IR_SET:
+        case BF_IR_MUL:
+        case BF_IR_PRODUCT:
+        case BF_IR_INPUT:
+            break;
+        default:
+            continue;
+        }
+
+        if (ctx->writes_size == ctx->writes_cap)
+        {
+            ctx->writes_cap = (ctx->writes_cap == 0) ? 64 : (ctx->writes_cap * 2);
+            ctx->writes = bf_realloc(ctx->writes, ctx->writes_cap * sizeof(int32_t));
+        }
+        ctx->writes[ctx->writes_size++] = cur + op->off;
+    }
+    return cur == 0;
+}
+
+static void bf_known_forget_writes(bf_known_ctx* ctx, const bf_ir* ir, uint32_t begin, uint32_t end)
+{
+    if (!ctx->track_tape || !bf_known_collect_writes(ctx, ir, begin, end))
+    {
+        bf_known_forget_all(&ctx->state);
+        return;
+    }
+    for (size_t i = 0; i != ctx->writes_size; ++i)
+        bf_known_put(ctx, ctx->writes[i], 0, 0);
+}
+
+static bf_known_frame* bf_known_push_frame(bf_known_ctx* ctx, uint32_t end, int unwrapped)
+{
+    if (ctx->frames_size == ctx->frames_cap)
+    {
+        size_t newcap = (ctx->frames_cap == 0) ? 16 : (ctx->frames_cap * 2);
+        ctx->frames = bf_realloc(ctx->frames, newcap * sizeof(bf_known_frame));
+        for (size_t i = ctx->frames_cap; i != newcap; ++i)
+        {
+            ctx->frames[i].state.cells = NULL;
+            ctx->frames[i].state.cap = 0;
+        }
+        ctx->frames_cap = newcap;
+    }
+    bf_known_frame* f = &ctx->frames[ctx->frames_size++];
+    f->end = end;
+    f->unwrapped = unwrapped;
+    bf_known_copy(&f->state, &ctx->state);
+    return f;
+}
+
+static void bf_known_add(bf_known_ctx* ctx, bf_ir* out, int32_t off, int32_t val)
+{
+    uint8_t value;
+    if (bf_known_get(&ctx->state, off, &value))
+    {
+        value = (uint8_t)(value + val);
+        bf_ir_push(out, BF_IR_SET, off, value);
+        bf_known_put(ctx, off, value, 1);
+    }
+    else
+    {
+        bf_ir_push(out, BF_IR_ADD, off, val);
+        bf_known_put(ctx, off, 0, 0);
+    }
+    bf_known_touch(&ctx->state, off);
+}
+
+// an access of cell[off] is left out, the cell is assumed to be zero if it
+// was never accessed, so outside of the cells shown to be on the tape a
+// bounds check has to stay in its place
+static void bf_known_drop(bf_known_ctx* ctx, bf_ir* out, int32_t off, uint32_t src)
+{
+    bf_knowledge* k = &ctx->state;
+    if (ctx->rtc && (off < k->lo || off > k->hi))
+    {
+        size_t i = bf_ir_push(out, BF_IR_CHECK, off, off);
+        out->ops[i].flags = BF_IR_PROBE;
+        out->ops[i].src = src;
+    }
+    bf_known_touch(k, off);
+}
+
+// constant output doesn't depend on the tape, so it can be merged into an
+// earlier write across cell updates, unless they may fail a bounds check
+// that should have happened before the output
+static int bf_write_can_cross(const bf_known_ctx* ctx, const bf_ir_op* op)
+{
+    if (op->kind == BF_IR_MOVE)
+        return !ctx->rtc;
+    if (op->kind == BF_IR_ADD || op->kind == BF_IR_SET)
+        return !ctx->rtc || op->off == 0;
+    return 0;
+}
+
+static void bf_known_write(bf_known_ctx* ctx, bf_ir* out, uint8_t value, int32_t count)
+{
+    size_t off = bf_ir_push_data(out, value, (size_t)count);
+    for (size_t i = out->size; i != 0; --i)
+    {
+        bf_ir_op* prev = &out->ops[i - 1];
+        if (prev->kind == BF_IR_WRITE && (size_t)prev->off + (size_t)prev->val == off &&
+            prev->val <= INT32_MAX - count)
+        {
+            prev->val += count;
+            return;
+        }
+        if (!bf_write_can_cross(ctx, prev))
+            break;
+    }
+    bf_ir_push(out, BF_IR_WRITE, (int32_t)off, count);
+}
+
+static void bf_pass_known_values_impl(bf_ir* ir, int track_tape, const bf_ir_options* opts)
+{
+    bf_ir out;
+    bf_ir_init_pass(&out, ir);
+    bf_known_ctx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.track_tape = track_tape;
+    ctx.rtc = opts->rtc;
+
+    // whole tape is zeroed at the start of the program, and the pointer starts on it
+    bf_known_forget_all(&ctx.state);
+    if (!opts->continued)
+    {
+        ctx.state.rest_zero = track_tape;
+        bf_known_put(&ctx, 0, 0, 1);
+        bf_known_touch(&ctx.state, 0);
+    }
+
+    for (uint32_t i = 0; i != ir->size; ++i)
+    {
+        bf_ir_op op = ir->ops[i];
+        uint8_t value;
+        int known = bf_known_get(&ctx.state, 0, &value);
+        int nonzero = (known && value != 0) || ctx.state.nonzero;
+
+        switch (op.kind)
+        {
+        case BF_IR_ADD:
+            bf_known_add(&ctx, &out, op.off, op.val);
+            break;
+        case BF_IR_SET:
+        {
+            uint8_t old;
+            if (!bf_known_get(&ctx.state, op.off, &old) || old != (uint8_t)op.val)
+            {
+                bf_ir_push_op(&out, &op);
+                bf_known_put(&ctx, op.off, (uint8_t)op.val, 1);
+                bf_known_touch(&ctx.state, op.off);
+            }
+            else
+            {
+                bf_known_drop(&ctx, &out, op.off, op.src);
+            }
+            break;
+        }
+        case BF_IR_MOVE:
+            bf_ir_push_op(&out, &op);
+            bf_known_move(&ctx, op.val);
+            break;
+        case BF_IR_INPUT:
+            bf_ir_push_op(&out, &op);
+            bf_known_put(&ctx, 0, 0, 0);
+            bf_known_touch(&ctx.state, 0);
+            break;
+        case BF_IR_OUTPUT:
+            if (known)
+            {
+                bf_known_drop(&ctx, &out, 0, op.src);
+                bf_known_write(&ctx, &out, value, op.val);
+            }
+            else
+            {
+                bf_ir_push_op(&out, &op);
+                bf_known_touch(&ctx.state, 0);
+            }
+            break;
+        case BF_IR_MUL:
+            if (known)
+            {
+                int32_t val = bf_wrap_add(op.val * value);
+                bf_known_drop(&ctx, &out, 0, op.src);
+                if (val != 0)
+                    bf_known_add(&ctx, &out, op.off, val);
+                else
+                    bf_known_drop(&ctx, &out, op.off, op.src);
+            }
+            else
+            {
+                bf_ir_push_op(&out, &op);
+                bf_known_put(&ctx, op.off, 0, 0);
+                bf_known_touch(&ctx.state, 0);
+                bf_known_touch(&ctx.state, op.off);
+            }
+            break;
+        case BF_IR_PRODUCT:
+        {
+            uint8_t factor;
+            int factor_known = bf_known_get(&ctx.state, op.val, &factor);
+            if ((known && value == 0) || (factor_known && factor == 0))
+            {
+                bf_known_drop(&ctx, &out, 0, op.src);
+                bf_known_drop(&ctx, &out, op.val, op.src);
+                bf_known_drop(&ctx, &out, op.off, op.src);
+                break;
+            }
+            if (known && factor_known)
+            {
+                bf_known_drop(&ctx, &out, 0, op.src);
+                bf_known_drop(&ctx, &out, op.val, op.src);
+                bf_known_add(&ctx, &out, op.off, bf_wrap_add(value * factor));
+                break;
+            }
+            if (factor_known)
+            {
+                bf_known_drop(&ctx, &out, op.val, op.src);
+                op.kind = BF_IR_MUL;
+                op.val = bf_wrap_add(factor);
+            }
+            else
+            {
+                bf_known_touch(&ctx.state, op.val);
+            }
+            bf_ir_push_op(&out, &op);
+            bf_known_put(&ctx, op.off, 0, 0);
+            bf_known_touch(&ctx.state, 0);
+            bf_known_touch(&ctx.state, op.off);
+            break;
+        }
+        case BF_IR_SCAN:
+            if (known && value == 0)
+            {
+                bf_known_drop(&ctx, &out, 0, op.src);
+                break;
+            }
+            if (nonzero)
+                op.flags |= BF_IR_ENTERED;
+            bf_ir_push_op(&out, &op);
+            bf_known_forget_all(&ctx.state);
+            bf_known_put(&ctx, 0, 0, 1);
+            bf_known_touch(&ctx.state, 0);
+            break;
+        case BF_IR_LOOP:
+            if (known && value == 0)
+            {
+                bf_known_drop(&ctx, &out, 0, op.src);
+                i = op.link;
+                break;
+            }
+            if (nonzero)
+                op.flags |= BF_IR_ENTERED;
+            bf_ir_push_op(&out, &op);
+
+            // state at the beginning of every iteration
+            bf_known_forget_writes(&ctx, ir, i, op.link);
+            bf_known_touch(&ctx.state, 0);
+            bf_known_push_frame(&ctx, op.link, 0);
+            ctx.state.nonzero = 1;
+            break;
+        case BF_IR_IF:
+            if (known && value == 0)
+            {
+                bf_known_drop(&ctx, &out, 0, op.src);
+                i = op.link;
+                break;
+            }
+            // body of an if never changes cell[0], so it can be inlined
+            // when the condition is known
+            if (nonzero)
+            {
+                bf_known_drop(&ctx, &out, 0, op.src);
+                bf_known_push_frame(&ctx, op.link, 1);
+                break;
+            }
+            bf_ir_push_op(&out, &op);
+            bf_known_touch(&ctx.state, 0);
+            bf_known_push_frame(&ctx, op.link, 0);
+            ctx.state.nonzero = 1;
+            break;
+        case BF_IR_END:
+        {
+            assert(ctx.frames_size != 0);
+            bf_known_frame* f = &ctx.frames[--ctx.frames_size];
+            assert(f->end == i);
+
+            if (ir->ops[op.link].kind == BF_IR_LOOP)
+            {
+                if (known && value == 0)
+                    op.flags |= BF_IR_ONCE;
+                bf_ir_push_op(&out, &op);
+                bf_known_copy(&ctx.state, &f->state);
+                bf_known_put(&ctx, 0, 0, 1);
+            }
+            else if (!f->unwrapped)
+            {
+                bf_ir_push_op(&out, &op);
+                bf_known_copy(&ctx.state, &f->state);
+                bf_known_forget_writes(&ctx, ir, op.link, i);
+            }
+            break;
+        }
+        default:
+            bf_ir_push_op(&out, &op);
+            break;
+        }
+    }
+
+    for (size_t i = 0; i != ctx.frames_cap; ++i)
+        bf_free(ctx.frames[i].state.cells);
+    bf_free(ctx.frames);
+    bf_free(ctx.writes);
+    bf_free(ctx.state.cells);
+
+    bf_ir_replace(ir, &out);
+}
+
+static void bf_pass_known_values(bf_ir* ir, const bf_ir_options* opts)
+{
+    bf_pass_known_values_impl(ir, 0, opts);
+}
+
+static void bf_pass_known_tape(bf_ir* ir, const bf_ir_options* opts)
+{
+    bf_pass_known_values_impl(ir, 1, opts);
+}
+
+/*
+ *  Pass: run the program up to its first input at compile time and replace
+ *  that part with the output it produces and one INIT of the tape it leaves.
+ *  Top-level ops are run whole, the first one that reads input or goes over
+ *  a limit is undone and the program continues from it.
+ */
+
+// steps spent before giving up, programs running longer than that pay for them in compile time
+#define BF_EVAL_MAX_STEPS (1 << 18)
+// cells from -BF_EVAL_MAX_CELLS / 2 up to BF_EVAL_MAX_CELLS / 2 are tracked
+#define BF_EVAL_MAX_CELLS (1 << 16)
+#define BF_EVAL_MAX_OUTPUT (1 << 20)
+// with bounds checking, writes after the accessed range grew that are checked in between
+#define BF_EVAL_MAX_MARKS 1024
+
+typedef struct {
+    int32_t cell;
+    uint8_t value;
+} bf_eval_undo;
+
+// state that top-level ops are undone to
+typedef struct {
+    int32_t ptr;
+    int32_t lo, hi;         // cells accessed so far
+    uint32_t lo_src;        // ops accessing them first
+    uint32_t hi_src;
+    size_t lo_step;         // and when they did
+    size_t hi_step;
+    size_t output_size;
+    size_t marks_size;
+} bf_eval_point;
+
+typedef struct {
+    const bf_ir* ir;
+    int rtc;
+    uint8_t* cells;
+    bf_eval_point at;
+    unsigned char* output;
+    size_t output_cap;
+    bf_eval_point* marks;   // where output was written after the accessed range grew
+    size_t marks_cap;
+    bf_eval_undo* undo;     // old values of cells written by the current top-level op
+    size_t undo_size;
+    size_t undo_cap;
+    size_t steps;
+} bf_eval;
+
+// returns NULL if the cell isn't tracked, the pointer visiting a cell counts
+// as an access like it does for bounds checks
+static uint8_t* bf_eval_cell(bf_eval* ev, int64_t cell, uint32_t src)
+{
+    if (cell < -BF_EVAL_MAX_CELLS / 2 || cell >= BF_EVAL_MAX_CELLS / 2)
+        return NULL;
+    if (cell < ev->at.lo)
+    {
+        ev->at.lo = (int32_t)cell;
+        ev->at.lo_src = src;
+        ev->at.lo_step = ev->steps;
+    }
+    if (cell > ev->at.hi)
+    {
+        ev->at.hi = (int32_t)cell;
+        ev->at.hi_src = src;
+        ev->at.hi_step = ev->steps;
+    }
+    return &ev->cells[cell + BF_EVAL_MAX_CELLS / 2];
+}
+
+static void bf_eval_set(bf_eval* ev, uint8_t* c, uint8_t value)
+{
+    if (ev->undo_size == ev->undo_cap)
+    {
+        ev->undo_cap = (ev->undo_cap == 0) ? 256 : (ev->undo_cap * 2);
+        ev->undo = bf_realloc(ev->undo, ev->undo_cap * sizeof(bf_eval_undo));
+    }
+    bf_eval_undo* u = &ev->undo[ev->undo_size++];
+    u->cell = (int32_t)(c - ev->cells);
+    u->value = *c;
+    *c = value;
+}
+
+static int bf_eval_output(bf_eval* ev, const unsigned char* data, uint8_t value, size_t count)
+{
+    if (count > BF_EVAL_MAX_OUTPUT - ev->at.output_size)
+        return 0;
+    // output has to come after the checks of the cells accessed before it
+    const bf_eval_point* last = (ev->at.marks_size != 0) ? &ev->marks[ev->at.marks_size - 1] : NULL;
+    if (ev->rtc && (last ? (last->lo != ev->at.lo || last->hi != ev->at.hi) : (ev->at.lo != 0 || ev->at.hi != 0)))
+    {
+        if (ev->at.marks_size == BF_EVAL_MAX_MARKS)
+            return 0;
+        if (ev->at.marks_size == ev->marks_cap)
+        {
+            ev->marks_cap = (ev->marks_cap == 0) ? 16 : (ev->marks_cap * 2);
+            ev->marks = bf_realloc(ev->marks, ev->marks_cap * sizeof(bf_eval_point));
+        }
+        ev->marks[ev->at.marks_size] = ev->at;
+        ++ev->at.marks_size;
+    }
+    if (ev->at.output_size + count > ev->output_cap)
+    {
+        ev->output_cap = (ev->output_cap == 0) ? 1024 : (ev->output_cap * 2);
+        if (ev->output_cap < ev->at.output_size + count)
+            ev->output_cap = ev->at.output_size + count;
+        ev->output = bf_realloc(ev->output, ev->output_cap);
+    }
+    if (data)
+        memcpy(ev->output + ev->at.output_size, data, count);
+    else
+        memset(ev->output + ev->at.output_size, value, count);
+    ev->at.output_size += count;
+    return 1;
+}
+
+// runs ops in [begin, end), returns 0 if they read input or go over a limit
+static int bf_eval_run(bf_eval* ev, size_t begin, size_t end)
+{
+    const bf_ir* ir = ev->ir;
+    size_t i = begin;
+    while (i != end)
+    {
+        if (++ev->steps > BF_EVAL_MAX_STEPS)
+            return 0;
+        const bf_ir_op* op = &ir->ops[i];
+        uint8_t* cur = bf_eval_cell(ev, ev->at.ptr, op->src);
+        if (!cur)
+            return 0;
+        uint8_t* c;
+        switch (op->kind)
+        {
+        case BF_IR_ADD:
+        case BF_IR_SET:
+            if (!(c = bf_eval_cell(ev, (int64_t)ev->at.ptr + op->off, op->src)))
+                return 0;
+            bf_eval_set(ev, c, (uint8_t)(op->kind == BF_IR_ADD ? *c + op->val : op->val));
+            break;
+        case BF_IR_MUL:
+            if (!(c = bf_eval_cell(ev, (int64_t)ev->at.ptr + op->off, op->src)))
+                return 0;
+            bf_eval_set(ev, c, (uint8_t)(*c + *cur * op->val));
+            break;
+        case BF_IR_PRODUCT:
+        {
+            const uint8_t* factor = bf_eval_cell(ev, (int64_t)ev->at.ptr + op->val, op->src);
+            if (!factor || !(c = bf_eval_cell(ev, (int64_t)ev->at.ptr + op->off, op->src)))
+                return 0;
+            bf_eval_set(ev, c, (uint8_t)(*c + *cur * *factor));
+            break;
+        }
+        case BF_IR_MOVE:
+            if (!bf_eval_cell(ev, (int64_t)ev->at.ptr + op->val, op->src))
+                return 0;
+            ev->at.ptr += op->val;
+            break;
+        case BF_IR_INPUT:
+            return 0;
+        case BF_IR_OUTPUT:
+            if (!bf_eval_output(ev, NULL, *cur, (size_t)op->val))
+                return 0;
+            break;
+        case BF_IR_WRITE:
+            if (!bf_eval_output(ev, ir->data + op->off, 0, (size_t)op->val))
+                return 0;
+            break;
+        case BF_IR_LOOP:
+        case BF_IR_IF:
+            if (*cur == 0)
+            {
+                i = op->link + 1;
+                continue;
+            }
+            break;
+        case BF_IR_END:
+            if (ir->ops[op->link].kind == BF_IR_LOOP && *cur != 0)
+            {
+                i = op->link + 1;
+                continue;
+            }
+            break;
+        case BF_IR_CHECK:
+            if (!bf_eval_cell(ev, (int64_t)ev->at.ptr + op->off, op->src))
+                return 0;
+            break;
+        case BF_IR_SCAN:
+            while (*cur != 0)
+            {
+                if (++ev->steps > BF_EVAL_MAX_STEPS || !(cur = bf_eval_cell(ev, (int64_t)ev->at.ptr + op->val, op->src)))
+                    return 0;
+                ev->at.ptr += op->val;
+            }
+            break;
+        default:
+            assert(0);
+        }
+        ++i;
+    }
+    return 1;
+}
+
+// writes the output from 'written' up to 'size', returns 'size'
+static size_t bf_eval_emit_output(bf_ir* out, const bf_eval* ev, size_t written, size_t size)
+{
+    if (size != written)
+    {
+        size_t off = bf_ir_push_bytes(out, ev->output + written, size - written);
+        bf_ir_push(out, BF_IR_WRITE, (int32_t)off, (int32_t)(size - written));
+    }
+    return size;
+}
+
+static void bf_eval_emit_probe(bf_ir* out, int32_t cell, uint32_t src)
+{
+    size_t i = bf_ir_push(out, BF_IR_CHECK, cell, cell);
+    out->ops[i].flags = BF_IR_PROBE;
+    out->ops[i].src = src;
+}
+
+// checks the cells the accessed range grew by from 'checked' to 'at' in the
+// order the program reached them, after the output written before that
+static size_t bf_eval_emit_checks(bf_ir* out, const bf_eval* ev, const bf_eval_point* checked,
+                                  const bf_eval_point* at, size_t written)
+{
+    written = bf_eval_emit_output(out, ev, written, at->output_size);
+    int lo = at->lo < checked->lo;
+    int hi = at->hi > checked->hi;
+    if (lo && !(hi && at->hi_step < at->lo_step))
+    {
+        bf_eval_emit_probe(out, at->lo, at->lo_src);
+        lo = 0;
+    }
+    if (hi)
+        bf_eval_emit_probe(out, at->hi, at->hi_src);
+    if (lo)
+        bf_eval_emit_probe(out, at->lo, at->lo_src);
+    return written;
+}
+
+static void bf_pass_eval_prefix(bf_ir* ir, const bf_ir_options* opts)
+{
+    // continued ops start with an unknown tape
+    if (!opts->eval_prefix || opts->continued)
+        return;
+
+    bf_eval ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.ir = ir;
+    ev.rtc = opts->rtc;
+    ev.cells = bf_zero_alloc(BF_EVAL_MAX_CELLS);
+    ev.at.lo_src = BF_IR_NO_SRC;
+    ev.at.hi_src = BF_IR_NO_SRC;
+
+    size_t done = 0;
+    while (done != ir->size)
+    {
+        const bf_ir_op* op = &ir->ops[done];
+        size_t end = (op->kind == BF_IR_LOOP || op->kind == BF_IR_IF) ? op->link + 1 : done + 1;
+        bf_eval_point start = ev.at;
+        ev.undo_size = 0;
+        if (!bf_eval_run(&ev, done, end))
+        {
+            while (ev.undo_size != 0)
+            {
+                const bf_eval_undo* u = &ev.undo[--ev.undo_size];
+                ev.cells[u->cell] = u->value;
+            }
+            ev.at = start;
+            break;
+        }
+        done = end;
+    }
+
+    if (done != 0)
+    {
+        bf_ir out;
+        bf_ir_init_pass(&out, ir);
+        // the cell the pointer starts at is always on the tape
+        bf_eval_point none;
+        memset(&none, 0, sizeof(none));
+        const bf_eval_point* checked = &none;
+        size_t written = 0;
+        for (size_t i = 0; i != ev.at.marks_size; ++i)
+        {
+            written = bf_eval_emit_checks(&out, &ev, checked, &ev.marks[i], written);
+            checked = &ev.marks[i];
+        }
+        if (opts->rtc)
+            bf_eval_emit_checks(&out, &ev, checked, &ev.at, written);
+        else
+            bf_eval_emit_output(&out, &ev, written, ev.at.output_size);
+
+        // cells from the first non-zero one up to the last one
+        const uint8_t* cells = ev.cells + BF_EVAL_MAX_CELLS / 2;
+        int32_t first = ev.at.lo;
+        int32_t last = ev.at.hi;
+        while (first <= last && cells[first] == 0)
+            ++first;
+        while (last > first && cells[last] == 0)
+            --last;
+        int32_t ptr = 0;
+        if (first <= last)
+        {
+            if (first != 0)
+                bf_ir_push(&out, BF_IR_MOVE, 0, first);
+            size_t off = bf_ir_push_bytes(&out, cells + first, (size_t)(last - first + 1));
+            bf_ir_push(&out, BF_IR_INIT, (int32_t)off, last - first + 1);
+            ptr = first;
+        }
+        if (ev.at.ptr != ptr)
+            bf_ir_push(&out, BF_IR_MOVE, 0, ev.at.ptr - ptr);
+        for (size_t i = done; i != ir->size; ++i)
+            bf_ir_push_op(&out, &ir->ops[i]);
+        bf_ir_replace(ir, &out);
+    }
+
+    bf_free(ev.cells);
+    bf_free(ev.output);
+    bf_free(ev.undo);
+    bf_free(ev.marks);
+}
+
+/*
+ *  Pass: insert bounds checks. Cells between two cells within the tape are
+ *  within the tape too, so the pass tracks the range of cells known to be in
+ *  bounds relative to the pointer and checks only accesses outside of it.
+ *  One check covers a whole straight-line run up to the next loop or i/o,
+ *  so that output written before a failing access is never held back by
+ *  its check. Loops that move the pointer by the same distance on every
+ *  iteration check the cells their body accesses unconditionally before
+ *  any i/o once on entry. Balanced ones, which leave the pointer where they found it,
+ *  keep that range for every iteration, others keep the part behind the
+ *  pointer, which the previous iteration has accessed. Cells known at the
+ *  end of a body whatever was known at its start are known at the start of
+ *  the next iteration too.
+ */
+
+// always contains the cell under the pointer
+typedef struct {
+    int32_t lo;
+    int32_t hi;
+} bf_range;
+
+static void bf_range_extend(bf_range* r, int32_t off)
+{
+    if (off < r->lo)
+        r->lo = off;
+    if (off > r->hi)
+        r->hi = off;
+}
+
+static bf_range bf_range_union(bf_range a, bf_range b)
+{
+    bf_range_extend(&a, b.lo);
+    bf_range_extend(&a, b.hi);
+    return a;
+}
+
+static bf_range bf_range_intersect(bf_range a, bf_range b)
+{
+    bf_range r;
+    r.lo = (a.lo > b.lo) ? a.lo : b.lo;
+    r.hi = (a.hi < b.hi) ? a.hi : b.hi;
+    return r;
+}
+
+// body of a loop or if
+typedef struct {
+    int fixed;          // all pointer movements are known statically
+    int32_t stride;     // net pointer movement of a fixed body
+    bf_range must;      // cells a fixed body accesses on every pass before any i/o, relative to its start
+    int io;             // fixed body may do i/o
+    bf_range end;       // known at the end of the body when nothing was known at its start
+} bf_region;
+
+typedef struct {
+    size_t begin;
+    bf_range before;    // known when the loop or if was reached
+    bf_range head;      // known at the start of every iteration
+} bf_check_frame;
+
+typedef struct {
+    const bf_ir* ir;
+    bf_region* regions;     // indexed by LOOP and IF ops
+    bf_ir* out;             // NULL while only computing the ranges
+    bf_check_frame* frames;
+    size_t frames_size;
+    size_t frames_cap;
+} bf_check_ctx;
+
+// cells accessed by a straight-line run, and source offsets of the ops
+// reaching its lowest and highest cell first, i/o ends a run
+typedef struct {
+    bf_range cells;
+    uint32_t lo_src;
+    uint32_t hi_src;
+} bf_run;
+
+// extends 'known' by 'need' and emits checks of the cells outside of it, the
+// sides of the range are checked separately if they have different sources
+static void bf_check_range(bf_ir* out, bf_range* known, bf_range need, uint8_t flags, uint32_t lo_src,
+                           uint32_t hi_src)
+{
+    int32_t lo = (need.lo < known->lo) ? need.lo : 0;
+    int32_t hi = (need.hi > known->hi) ? need.hi : 0;
+    *known = bf_range_union(*known, need);
+    if (!out || (lo == 0 && hi == 0))
+        return;
+    if (lo != 0 && hi != 0 && lo_src != hi_src)
+    {
+        size_t i = bf_ir_push(out, BF_IR_CHECK, lo, 0);
+        out->ops[i].flags = flags;
+        out->ops[i].src = lo_src;
+        lo = 0;
+    }
+    size_t i = bf_ir_push(out, BF_IR_CHECK, lo, hi);
+    out->ops[i].flags = flags;
+    out->ops[i].src = (lo != 0) ? lo_src : hi_src;
+}
+
+// cells accessed by the straight-line run starting at 'begin'
+static bf_run bf_run_range(const bf_ir* ir, size_t begin)
+{
+    bf_run run = {{0, 0}, BF_IR_NO_SRC, BF_IR_NO_SRC};
+    int32_t pos = 0;
+    for (size_t i = begin; i != ir->size; ++i)
+    {
+        const bf_ir_op* op = &ir->ops[i];
+        int32_t cell;
+        if (op->kind == BF_IR_MOVE)
+            cell = pos += op->val;
+        else if (op->kind == BF_IR_ADD || op->kind == BF_IR_SET || op->kind == BF_IR_MUL)
+            cell = pos + op->off;
+        else if (op->kind == BF_IR_PRODUCT || op->kind == BF_IR_INIT)
+        {
+            // the factor of a product, the last cell of an init
+            int32_t other = pos + ((op->kind == BF_IR_PRODUCT) ? op->val : op->val - 1);
+            cell = pos + ((op->kind == BF_IR_PRODUCT) ? op->off : 0);
+            if (other < run.cells.lo)
+                run.lo_src = op->src;
+            if (other > run.cells.hi)
+                run.hi_src = op->src;
+            bf_range_extend(&run.cells, other);
+        }
+        else
+            break;
+
+        if (cell < run.cells.lo)
+            run.lo_src = op->src;
+        if (cell > run.cells.hi)
+            run.hi_src = op->src;
+        bf_range_extend(&run.cells, cell);
+    }
+    return run;
+}
+
+// known at the start of every iteration of a loop reached with 'before', and
+// the part of it that has to be checked on entry
+static bf_range bf_loop_head(const bf_region* r, bf_range before, bf_range* hoisted)
+{
+    hoisted->lo = 0;
+    hoisted->hi = 0;
+    if (r->fixed)
+    {
+        *hoisted = r->must;
+        if (r->stride > 0)
+            hoisted->hi = 0;
+        else if (r->stride < 0)
+            hoisted->lo = 0;
+    }
+    if (r->fixed && r->stride == 0)
+        return bf_range_union(before, *hoisted);
+    return bf_range_union(bf_range_intersect(before, r->end), *hoisted);
+}
+
+// known after a loop or if reached with 'before' that ended its last pass with 'end'
+static bf_range bf_region_exit(const bf_ir_op* begin, bf_range before, bf_range end)
+{
+    return (begin->flags & BF_IR_ENTERED) ? end : bf_range_intersect(before, end);
+}
+
+/*
+ *  Walks ops in [begin, end) starting with 'known' and returns the range
+ *  known at the end. Without output nested bodies are not walked, their
+ *  summaries stand in for them.
+ */
+static bf_range bf_checks_walk(bf_check_ctx* ctx, size_t begin, size_t end, bf_range known)
+{
+    const bf_ir* ir = ctx->ir;
+    int in_run = 0;
+    for (size_t i = begin; i != end; ++i)
+    {
+        bf_ir_op op = ir->ops[i];
+        switch (op.kind)
+        {
+        case BF_IR_LOOP:
+        case BF_IR_IF:
+        {
+            const bf_region* r = &ctx->regions[i];
+            bf_range head = known;
+            bf_range hoisted = {0, 0};
+            if (op.kind == BF_IR_LOOP)
+            {
+                head = bf_loop_head(r, known, &hoisted);
+                op.off = known.lo;
+                op.val = known.hi;
+            }
+
+            if (!ctx->out)
+            {
+                // fixed balanced bodies only add to what they start with
+                bf_range last = r->end;
+                if (r->fixed && r->stride == 0)
+                    last = bf_range_union(head, r->end);
+                known = bf_region_exit(&op, known, last);
+                i = op.link;
+            }
+            else
+            {
+                bf_ir_push_op(ctx->out, &op);
+                bf_range entry = known;
+                bf_check_range(ctx->out, &entry, hoisted, BF_IR_HOISTED, op.src, op.src);
+
+                if (ctx->frames_size == ctx->frames_cap)
+                {
+                    ctx->frames_cap = (ctx->frames_cap == 0) ? 16 : (ctx->frames_cap * 2);
+                    ctx->frames = bf_realloc(ctx->frames, ctx->frames_cap * sizeof(bf_check_frame));
+                }
+                bf_check_frame* f = &ctx->frames[ctx->frames_size++];
+                f->begin = i;
+                f->before = known;
+                f->head = head;
+                known = head;
+            }
+            in_run = 0;
+            break;
+        }
+        case BF_IR_END:
+        {
+            const bf_check_frame* f = &ctx->frames[--ctx->frames_size];
+            known = bf_region_exit(&ir->ops[f->begin], f->before, known);
+            if (ir->ops[f->begin].kind == BF_IR_LOOP)
+            {
+                op.off = f->head.lo;
+                op.val = f->head.hi;
+            }
+            bf_ir_push_op(ctx->out, &op);
+            in_run = 0;
+            break;
+        }
+        case BF_IR_SCAN:
+            known.lo = 0;
+            known.hi = 0;
+            if (ctx->out)
+                bf_ir_push_op(ctx->out, &op);
+            in_run = 0;
+            break;
+        case BF_IR_CHECK:
+            // left by earlier passes, accesses after it start another run
+            assert(op.flags & BF_IR_PROBE);
+            bf_range_extend(&known, op.off);
+            if (ctx->out)
+                bf_ir_push_op(ctx->out, &op);
+            in_run = 0;
+            break;
+        default:
+            if (!in_run)
+            {
+                bf_run run = bf_run_range(ir, i);
+                bf_check_range(ctx->out, &known, run.cells, 0, run.lo_src, run.hi_src);
+                in_run = 1;
+            }
+            if (op.kind == BF_IR_MOVE)
+            {
+                known.lo -= op.val;
+                known.hi -= op.val;
+            }
+            if (ctx->out)
+                bf_ir_push_op(ctx->out, &op);
+            if (bf_is_io_op(&op))
+                in_run = 0;
+            break;
+        }
+    }
+    return known;
+}
+
+// nested bodies are summarized before the ones containing them
+static void bf_region_summarize(bf_check_ctx* ctx, size_t begin)
+{
+    const bf_ir* ir = ctx->ir;
+    bf_region* r = &ctx->regions[begin];
+    r->fixed = 1;
+    r->stride = 0;
+    r->must.lo = 0;
+    r->must.hi = 0;
+    r->io = 0;
+
+    // accesses after i/o can't be checked before it
+    bf_range none = {0, 0};
+    bf_range* must = &r->must;
+    int32_t pos = 0;
+    for (size_t i = begin + 1; i != ir->ops[begin].link && r->fixed; ++i)
+    {
+        const bf_ir_op* op = &ir->ops[i];
+        switch (op->kind)
+        {
+        case BF_IR_MOVE:
+            bf_range_extend(must, pos += op->val);
+            break;
+        case BF_IR_ADD:
+        case BF_IR_SET:
+        case BF_IR_MUL:
+            bf_range_extend(must, pos + op->off);
+            break;
+        case BF_IR_PRODUCT:
+            bf_range_extend(must, pos + op->off);
+            bf_range_extend(must, pos + op->val);
+            break;
+        case BF_IR_INPUT:
+        case BF_IR_OUTPUT:
+        case BF_IR_WRITE:
+            r->io = 1;
+            must = &none;
+            break;
+        case BF_IR_LOOP:
+        case BF_IR_IF:
+        {
+            // skipped bodies leave the pointer where it was as well
+            const bf_region* inner = &ctx->regions[i];
+            if (!inner->fixed || inner->stride != 0)
+                r->fixed = 0;
+            else if (op->flags & BF_IR_ENTERED)
+                *must = bf_range_union(*must, (bf_range){pos + inner->must.lo, pos + inner->must.hi});
+            if (inner->io)
+            {
+                r->io = 1;
+                must = &none;
+            }
+            i = op->link;
+            break;
+        }
+        case BF_IR_SCAN:
+            r->fixed = 0;
+            break;
+        default:
+            break;
+        }
+    }
+    r->stride = pos;
+
+    bf_range start = {0, 0};
+    r->end = bf_checks_walk(ctx, begin + 1, ir->ops[begin].link, start);
+}
+
+static void bf_pass_insert_checks(bf_ir* ir)
+{
+    bf_check_ctx ctx;
+    ctx.ir = ir;
+    ctx.regions = bf_realloc(NULL, ir->size * sizeof(bf_region));
+    ctx.out = NULL;
+    ctx.frames = NULL;
+    ctx.frames_size = 0;
+    ctx.frames_cap = 0;
+
+    for (size_t i = 0; i != ir->size; ++i)
+        if (ir->ops[i].kind == BF_IR_END)
+            bf_region_summarize(&ctx, ir->ops[i].link);
+
+    bf_ir out;
+    bf_ir_init_pass(&out, ir);
+    ctx.out = &out;
+    bf_range start = {0, 0};
+    bf_checks_walk(&ctx, 0, ir->size, start);
+
+    bf_free(ctx.frames);
+    bf_free(ctx.regions);
+    bf_ir_replace(ir, &out);
+}
+
+/*
+ *  Pass manager
+ */
+
+typedef struct {
+    const char* name;
+    int level;
+    void (*run)(bf_ir* ir, const bf_ir_options* opts);
+} bf_pass;
+
+static const bf_pass bf_pipeline[] = {
+    {"fold-offsets", 1, bf_pass_fold_offsets},
+    {"loop-idioms",  2, bf_pass_loop_idioms},
+    {"fold-offsets", 2, bf_pass_fold_offsets},
+    {"known-values", 2, bf_pass_known_values},
+    {"known-tape",   3, bf_pass_known_tape},
+    {"fold-offsets", 3, bf_pass_fold_offsets},
+    {"eval-prefix",  2, bf_pass_eval_prefix},
+};
+
+void bf_ir_optimize(bf_ir* ir, const bf_ir_options* opts)
+{
+    for (size_t i = 0; i != sizeof(bf_pipeline) / sizeof(bf_pipeline[0]); ++i)
+    {
+        if (bf_pipeline[i].level <= opts->opt_level)
+            bf_pipeline[i].run(ir, opts);
+    }
+
+    if (opts->rtc)
+        bf_pass_insert_checks(ir);
+}
@@ -0,0 +1,275 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bfjit.h"
+#include "bfjit-memory.h"
+#include "bfjit-perf.h"
+
+#ifdef BF_HAVE_PERF
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+void bf_code_map_init(bf_code_map* map)
+{
+    map->regions = NULL;
+    map->size = 0;
+    map->cap = 0;
+}
+
+void bf_code_map_free(bf_code_map* map)
+{
+    bf_free(map->regions);
+    bf_code_map_init(map);
+}
+
+size_t bf_code_map_push(bf_code_map* map, size_t begin, uint32_t line, uint32_t col)
+{
+    if (map->size == map->cap)
+    {
+        map->cap = (map->cap == 0) ? 64 : (map->cap * 2);
+        map->regions = bf_realloc(map->regions, map->cap * sizeof(bf_code_region));
+    }
+    bf_code_region* r = &map->regions[map->size];
+    r->begin = begin;
+    r->end = begin;
+    r->line = line;
+    r->col = col;
+    return map->size++;
+}
+
+void bf_code_map_append(bf_code_map* map, const bf_code_map* part, size_t base)
+{
+    for (size_t i = 0; i != part->size; ++i)
+    {
+        const bf_code_region* r = &part->regions[i];
+        size_t j = bf_code_map_push(map, base + r->begin, r->line, r->col);
+        map->regions[j].end = base + r->end;
+    }
+}
+
+#ifdef BF_HAVE_PERF
+
+// code named by the innermost region containing it, NULL outside of all of them
+typedef void (*bf_symbol_func)(void* arg, size_t begin, size_t end, const bf_code_region* region);
+
+static void bf_code_map_symbols(const bf_code_map* map, size_t size, bf_symbol_func func, void* arg)
+{
+    const bf_code_region** open = bf_realloc(NULL, (map->size + 1) * sizeof(bf_code_region*));
+    size_t depth = 0;
+    size_t pos = 0;
+    for (size_t i = 0; i <= map->size; ++i)
+    {
+        // regions ending before the next one begins are finished
+        size_t next = (i == map->size) ? size : map->regions[i].begin;
+        while (depth != 0 && open[depth - 1]->end <= next)
+        {
+            const bf_code_region* r = open[--depth];
+            if (pos != r->end)
+                func(arg, pos, r->end, r);
+            pos = r->end;
+        }
+        if (pos != next)
+            func(arg, pos, next, (depth != 0) ? open[depth - 1] : NULL);
+        pos = next;
+        if (i != map->size)
+            open[depth++] = &map->regions[i];
+    }
+    bf_free((void*)open);
+}
+
+static void bf_symbol_name(char* name, size_t size, const bf_code_region* region)
+{
+    if (region)
+        snprintf(name, size, "loop@L%u:C%u", (unsigned)region->line, (unsigned)region->col);
+    else
+        snprintf(name, size, "program");
+}
+
+typedef struct {
+    FILE* file;
+    const unsigned char* mem;
+} bf_perf_map_ctx;
+
+static void bf_perf_map_symbol(void* arg, size_t begin, size_t end, const bf_code_region* region)
+{
+    bf_perf_map_ctx* ctx = arg;
+    char name[64];
+    bf_symbol_name(name, sizeof(name), region);
+    fprintf(ctx->file, "%llx %llx %s\n", (unsigned long long)(uintptr_t)(ctx->mem + begin),
+            (unsigned long long)(end - begin), name);
+}
+
+void bf_perf_write_map(const bf_code_map* map, const unsigned char* mem, size_t size)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/perf-%ld.map", (long)getpid());
+    bf_perf_map_ctx ctx;
+    ctx.file = fopen(path, "w");
+    if (!ctx.file)
+        bf_error("couldn't open file '%s'", path);
+    ctx.mem = mem;
+    bf_code_map_symbols(map, size, bf_perf_map_symbol, &ctx);
+    if (fclose(ctx.file) != 0)
+        bf_error("couldn't write file '%s'", path);
+}
+
+/*
+ *  jitdump format, as described in tools/perf/Documentation/jitdump-specification.txt
+ */
+
+#define BF_JITDUMP_MAGIC 0x4A695444
+#define BF_JITDUMP_VERSION 1
+#define BF_JITDUMP_EM_X86_64 62
+
+enum {
+    BF_JIT_CODE_LOAD = 0,
+    BF_JIT_CODE_DEBUG_INFO = 2,
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t total_size;
+    uint32_t elf_mach;
+    uint32_t pad1;
+    uint32_t pid;
+    uint64_t timestamp;
+    uint64_t flags;
+} bf_jitdump_header;
+
+typedef struct {
+    uint32_t id;
+    uint32_t total_size;
+    uint64_t timestamp;
+} bf_jitdump_record;
+
+typedef struct {
+    bf_jitdump_record rec;
+    uint32_t pid;
+    uint32_t tid;
+    uint64_t vma;
+    uint64_t code_addr;
+    uint64_t code_size;
+    uint64_t code_index;
+    // followed by the name and the code
+} bf_jitdump_code_load;
+
+typedef struct {
+    bf_jitdump_record rec;
+    uint64_t code_addr;
+    uint64_t nr_entry;
+    // followed by entries
+} bf_jitdump_debug_info;
+
+typedef struct {
+    uint64_t code_addr;
+    uint32_t line;
+    uint32_t discrim;
+    // followed by the file name
+} bf_jitdump_debug_entry;
+
+// the clock 'perf record -k mono' uses
+static uint64_t bf_jitdump_timestamp(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+typedef struct {
+    FILE* file;
+    const unsigned char* mem;
+    const char* source_file;
+    uint32_t pid;
+    uint32_t tid;
+    uint64_t index;
+} bf_jitdump_ctx;
+
+static void bf_jitdump_symbol(void* arg, size_t begin, size_t end, const bf_code_region* region)
+{
+    bf_jitdump_ctx* ctx = arg;
+    uint64_t addr = (uint64_t)(uintptr_t)(ctx->mem + begin);
+    uint64_t timestamp = bf_jitdump_timestamp();
+
+    // debug info precedes the code it describes
+    if (region)
+    {
+        bf_jitdump_debug_info info;
+        bf_jitdump_debug_entry entry;
+        size_t file_size = strlen(ctx->source_file) + 1;
+        info.rec.id = BF_JIT_CODE_DEBUG_INFO;
+        info.rec.total_size = (uint32_t)(sizeof(info) + sizeof(entry) + file_size);
+        info.rec.timestamp = timestamp;
+        info.code_addr = addr;
+        info.nr_entry = 1;
+        entry.code_addr = addr;
+        entry.line = region->line;
+        entry.discrim = 0;
+        fwrite(&info, sizeof(info), 1, ctx->file);
+        fwrite(&entry, sizeof(entry), 1, ctx->file);
+        fwrite(ctx->source_file, file_size, 1, ctx->file);
+    }
+
+    char name[64];
+    bf_symbol_name(name, sizeof(name), region);
+    size_t name_size = strlen(name) + 1;
+    bf_jitdump_code_load load;
+    load.rec.id = BF_JIT_CODE_LOAD;
+    load.rec.total_size = (uint32_t)(sizeof(load) + name_size + (end - begin));
+    load.rec.timestamp = timestamp;
+    load.pid = ctx->pid;
+    load.tid = ctx->tid;
+    load.vma = addr;
+    load.code_addr = addr;
+    load.code_size = end - begin;
+    load.code_index = ctx->index++;
+    fwrite(&load, sizeof(load), 1, ctx->file);
+    fwrite(name, name_size, 1, ctx->file);
+    fwrite(ctx->mem + begin, end - begin, 1, ctx->file);
+}
+
+void bf_perf_write_jitdump(const bf_code_map* map, const unsigned char* mem, size_t size, const char* source_file)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/jit-%ld.dump", (long)getpid());
+    bf_jitdump_ctx ctx;
+    ctx.file = fopen(path, "w+");
+    if (!ctx.file)
+        bf_error("couldn't open file '%s'", path);
+
+    // perf finds the file through this mapping in the recorded events
+    void* marker = mmap(NULL, (size_t)sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(ctx.file), 0);
+    if (marker == MAP_FAILED)
+        bf_error("couldn't map file '%s'", path);
+
+    char source_path[PATH_MAX];
+    ctx.mem = mem;
+    ctx.source_file = realpath(source_file, source_path) ? source_path : source_file;
+    ctx.pid = (uint32_t)getpid();
+    ctx.tid = (uint32_t)syscall(SYS_gettid);
+    ctx.index = 0;
+
+    bf_jitdump_header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = BF_JITDUMP_MAGIC;
+    header.version = BF_JITDUMP_VERSION;
+    header.total_size = sizeof(header);
+    header.elf_mach = BF_JITDUMP_EM_X86_64;
+    header.pid = ctx.pid;
+    header.timestamp = bf_jitdump_timestamp();
+    fwrite(&header, sizeof(header), 1, ctx.file);
+    bf_code_map_symbols(map, size, bf_jitdump_symbol, &ctx);
+
+    munmap(marker, (size_t)sysconf(_SC_PAGESIZE));
+    if (fclose(ctx.file) != 0)
+        bf_error("couldn't write file '%s'", path);
+}
+
+#endif
@@ -0,0 +1,115 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bfjit.h"
+#include "bfjit-memory.h"
+#include "bfjit-profile.h"
+
+// loops listed by the report
+#define BF_PROFILE_REPORT_SIZE 20
+
+void bf_profile_init(bf_profile* profile, const bf_ir* ir)
+{
+    size_t count = 0;
+    for (size_t i = 0; i != ir->size; ++i)
+        count += ir->ops[i].kind == BF_IR_LOOP;
+
+    profile->loops = bf_realloc(NULL, (count + 1) * sizeof(bf_profile_loop));
+    profile->size = 0;
+    for (size_t i = 0; i != ir->size; ++i)
+    {
+        const bf_ir_op* op = &ir->ops[i];
+        if (op->kind != BF_IR_LOOP)
+            continue;
+        bf_profile_loop* l = &profile->loops[profile->size++];
+        l->src = op->src;
+        bf_ir_source_position(ir, op->src, &l->line, &l->col);
+        l->kind = BF_PROFILE_REMOVED;
+    }
+    profile->counters = bf_zero_alloc((2 * count + 1) * sizeof(uint64_t));
+}
+
+void bf_profile_free(bf_profile* profile)
+{
+    bf_free(profile->loops);
+    bf_free(profile->counters);
+}
+
+int64_t bf_profile_find(const bf_profile* profile, uint32_t src)
+{
+    size_t lo = 0;
+    size_t hi = profile->size;
+    while (lo != hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (profile->loops[mid].src < src)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo != profile->size && profile->loops[lo].src == src)
+        return (int64_t)lo;
+    return -1;
+}
+
+typedef struct {
+    const bf_profile_loop* loop;
+    uint64_t entries;
+    uint64_t iterations;
+} bf_profile_row;
+
+// executions of the body, or of the replacing op when iterations aren't counted
+static uint64_t bf_profile_weight(const bf_profile_row* row)
+{
+    return (row->loop->kind == BF_PROFILE_LOOP) ? row->iterations : row->entries;
+}
+
+static int bf_profile_row_cmp(const void* a, const void* b)
+{
+    const bf_profile_row* x = a;
+    const bf_profile_row* y = b;
+    uint64_t wx = bf_profile_weight(x);
+    uint64_t wy = bf_profile_weight(y);
+    if (wx != wy)
+        return (wx < wy) - (wx > wy);
+    return (x->loop->src > y->loop->src) - (x->loop->src < y->loop->src);
+}
+
+void bf_profile_report(const bf_profile* profile)
+{
+    static const char* const kinds[] = {"removed", "loop", "scan", "copy", "set"};
+
+    bf_profile_row* rows = bf_realloc(NULL, (profile->size + 1) * sizeof(bf_profile_row));
+    size_t count = 0;
+    for (size_t i = 0; i != profile->size; ++i)
+    {
+        if (profile->loops[i].kind == BF_PROFILE_REMOVED)
+            continue;
+        bf_profile_row* row = &rows[count++];
+        row->loop = &profile->loops[i];
+        row->entries = profile->counters[2 * i];
+        row->iterations = profile->counters[2 * i + 1];
+    }
+    qsort(rows, count, sizeof(bf_profile_row), bf_profile_row_cmp);
+
+    size_t shown = (count < BF_PROFILE_REPORT_SIZE) ? count : BF_PROFILE_REPORT_SIZE;
+    printf("\n"
+           "Loop profile:   %zu of %zu loops compiled, top %zu\n"
+           "  line:col      kind         entries       iterations    avg trip\n",
+           count, profile->size, shown);
+    for (size_t i = 0; i != shown; ++i)
+    {
+        const bf_profile_row* row = &rows[i];
+        char pos[32];
+        snprintf(pos, sizeof(pos), "%" PRIu32 ":%" PRIu32, row->loop->line, row->loop->col);
+        printf("  %-13s %-8s %12" PRIu64, pos, kinds[row->loop->kind], row->entries);
+        if (row->loop->kind != BF_PROFILE_LOOP)
+            printf(" %16s %11s\n", "-", "-");
+        else if (row->entries == 0)
+            printf(" %16" PRIu64 " %11s\n", row->iterations, "-");
+        else
+            printf(" %16" PRIu64 " %11.1f\n", row->iterations, (double)row->iterations / (double)row->entries);
+    }
+    bf_free(rows);
+}
@@ -1,53 +1,255 @@
+#include <assert.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "bfjit.h"
+#include "bfjit-guard.h"
+#include "bfjit-io.h"
 #include "bfjit-memory.h"
 #include "bfjit-runtime.h"
 
-void bf_runtime_out_of_bounds() { bf_error("out of bounds memory access"); }
-
 #ifdef _WIN32
-#define bf_getchar _getchar_nolock
-#define bf_putchar _putchar_nolock
+#define bf_fwrite _fwrite_nolock
 #else
-#define bf_getchar getchar_unlocked
-#define bf_putchar putchar_unlocked
+#define bf_fwrite fwrite_unlocked
 #endif
 
-unsigned char bf_runtime_read_char_eof_zero()
+void bf_runtime_flush_output(bf_runtime_context* ctx)
+{
+    size_t size = (size_t)(ctx->output_cur - ctx->output_buffer);
+    if (size != 0 && bf_fwrite(ctx->output_buffer, 1, size, stdout) != size)
+        bf_error("couldn't write output");
+    ctx->output_cur = ctx->output_buffer;
+}
+
+// the buffer is flushed as soon as it fills up, compiled code relies
+// on at least one byte being free between calls
+void bf_runtime_write_output(bf_runtime_context* ctx, const unsigned char* data, size_t size)
+{
+    while (size != 0)
+    {
+        size_t space = BF_OUTPUT_BUFFER_SIZE - (size_t)(ctx->output_cur - ctx->output_buffer);
+        size_t n = size < space ? size : space;
+        memcpy(ctx->output_cur, data, n);
+        ctx->output_cur += n;
+        data += n;
+        size -= n;
+        if (n == space)
+            ctx->flush_output(ctx);
+    }
+}
+
+void bf_runtime_fill_output(bf_runtime_context* ctx, unsigned char value, size_t size)
+{
+    while (size != 0)
+    {
+        size_t space = BF_OUTPUT_BUFFER_SIZE - (size_t)(ctx->output_cur - ctx->output_buffer);
+        size_t n = size < space ? size : space;
+        memset(ctx->output_cur, value, n);
+        ctx->output_cur += n;
+        size -= n;
+        if (n == space)
+            ctx->flush_output(ctx);
+    }
+}
+
+void bf_runtime_out_of_bounds(bf_runtime_context* ctx, const unsigned char* ptr, const unsigned char* pc)
+{
+    ctx->flush_output(ctx);
+    long long cell = (long long)(ptr - ctx->tape_start);
+    uint32_t line, col;
+    if (ctx->source_map && pc && bf_source_map_find(ctx->source_map, (size_t)(pc - ctx->code), &line, &col))
+        bf_error("out of bounds memory access at line %u, column %u, the pointer is at cell %lld", (unsigned)line,
+                 (unsigned)col, cell);
+    bf_error("out of bounds memory access, the pointer is at cell %lld", cell);
+}
+
+// refills the input buffer, returns the next input byte or EOF
+static int bf_runtime_read_char(bf_runtime_context* ctx)
+{
+    // output written so far must be visible before the program waits for input
+    if (ctx->output_cur != ctx->output_buffer)
+    {
+        ctx->flush_output(ctx);
+        fflush(stdout);
+    }
+
+    if (ctx->input_eof)
+        return EOF;
+    if (ctx->input_buffer == NULL)
+        ctx->input_buffer = bf_realloc(NULL, BF_INPUT_BUFFER_SIZE);
+
+    size_t size = bf_read_file(ctx->input_file, ctx->input_buffer, BF_INPUT_BUFFER_SIZE);
+    if (size == 0)
+    {
+        ctx->input_eof = 1;
+        return EOF;
+    }
+    ctx->input_cur = ctx->input_buffer + 1;
+    ctx->input_end = ctx->input_buffer + size;
+    return ctx->input_buffer[0];
+}
+
+static void bf_runtime_open_input(bf_runtime_context* ctx, const char* input_filename)
 {
-    int c = bf_getchar();
+    ctx->input_file = input_filename ? bf_open_file_read(input_filename) : bf_stdin_file();
+    ctx->input_buffer = NULL;
+    ctx->input_eof = 0;
+    ctx->input_map = bf_map_file(ctx->input_file, &ctx->input_map_size);
+    if (ctx->input_map)
+    {
+        // whole input is available up front, the end of the mapping is eof
+        ctx->input_cur = ctx->input_map;
+        ctx->input_end = ctx->input_cur + ctx->input_map_size;
+        ctx->input_eof = 1;
+    }
+    else
+    {
+        ctx->input_cur = NULL;
+        ctx->input_end = NULL;
+    }
+}
+
+static void bf_runtime_close_input(bf_runtime_context* ctx, const char* input_filename)
+{
+    if (ctx->input_map)
+        bf_unmap_file(ctx->input_map, ctx->input_map_size);
+    bf_free(ctx->input_buffer);
+    if (input_filename)
+        bf_close_file(ctx->input_file);
+}
+
+unsigned char bf_runtime_read_char_eof_zero(bf_runtime_context* ctx)
+{
+    int c = bf_runtime_read_char(ctx);
     return c == EOF ? 0 : (unsigned char)c;
 }
 
-unsigned char bf_runtime_read_char_eof_minusone()
+unsigned char bf_runtime_read_char_eof_minusone(bf_runtime_context* ctx)
 {
-    int c = bf_getchar();
+    int c = bf_runtime_read_char(ctx);
     return c == EOF ? (unsigned char)-1 : (unsigned char)c;
 }
 
-unsigned char bf_runtime_read_char_eof_nochange(unsigned char old)
+unsigned char bf_runtime_read_char_eof_nochange(bf_runtime_context* ctx, unsigned char old)
 {
-    int c = bf_getchar();
+    int c = bf_runtime_read_char(ctx);
     return c == EOF ? old : (unsigned char)c;
 }
 
-void bf_runtime_write_char(unsigned char val) { bf_putchar(val); }
+static size_t bf_round_up(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+void bf_runtime_init(bf_runtime* rt, size_t guard_size, size_t tapesize, const char* input_filename)
+{
+    bf_runtime_context* ctx = &rt->ctx;
+    ctx->flush_output = bf_runtime_flush_output;
+    ctx->write_output = bf_runtime_write_output;
+    ctx->fill_output = bf_runtime_fill_output;
+    ctx->out_of_bounds = bf_runtime_out_of_bounds;
+    ctx->read_char_eof_zero = bf_runtime_read_char_eof_zero;
+    ctx->read_char_eof_minusone = bf_runtime_read_char_eof_minusone;
+    ctx->read_char_eof_nochange = bf_runtime_read_char_eof_nochange;
+    // first, a missing input file of a trapped run leaves nothing allocated
+    bf_runtime_open_input(ctx, input_filename);
+    rt->input_filename = input_filename;
+    // page aligned, which satisfies the alignment the compiled code relies on
+    ctx->output_buffer = bf_virtual_alloc(BF_OUTPUT_BUFFER_SIZE);
+    ctx->output_cur = ctx->output_buffer;
+    ctx->counters = NULL;
+    ctx->source_map = NULL;
+    ctx->code = NULL;
+    rt->guard_size = guard_size;
+
+    if (guard_size != 0)
+    {
+        size_t page = bf_page_size();
+        size_t guard = bf_round_up(guard_size, page);
+        bf_guard_region region;
+        if (tapesize == BF_TAPE_UNBOUNDED)
+        {
+            rt->memory_size = BF_UNBOUNDED_TAPE_RESERVE + 2 * guard;
+            rt->memory = bf_virtual_reserve(rt->memory_size);
+            ctx->tape_begin = rt->memory + guard;
+            ctx->tape_end = ctx->tape_begin + BF_UNBOUNDED_TAPE_RESERVE;
+            rt->tape = ctx->tape_begin + BF_UNBOUNDED_TAPE_RESERVE / 2;
+            region.grow_begin = ctx->tape_begin;
+            region.grow_end = ctx->tape_end;
+        }
+        else
+        {
+            // the end of the tape borders on the upper guard pages, the rest
+            // of its pages is left below its beginning, which compiled code
+            // checks explicitly
+            size_t committed = bf_round_up(tapesize, page);
+            rt->memory_size = committed + 2 * guard;
+            rt->memory = bf_virtual_reserve(rt->memory_size);
+            bf_virtual_commit(rt->memory + guard, committed);
+            rt->tape = rt->memory + guard + (committed - tapesize);
+            ctx->tape_begin = rt->tape;
+            ctx->tape_end = rt->tape + tapesize;
+            region.grow_begin = NULL;
+            region.grow_end = NULL;
+        }
+        region.begin = rt->memory;
+        region.end = rt->memory + rt->memory_size;
+        bf_guard_install(&region);
+    }
+    else
+    {
+        assert(tapesize != BF_TAPE_UNBOUNDED);
+        rt->memory_size = tapesize + 2 * BF_TAPE_PADDING;
+        rt->memory = bf_zero_alloc(rt->memory_size);
+        rt->tape = rt->memory + BF_TAPE_PADDING;
+        ctx->tape_begin = rt->tape;
+        ctx->tape_end = rt->tape + tapesize;
+    }
+    ctx->tape_start = rt->tape;
+}
 
-void bf_jit_run(bf_compiled_code* code, size_t tapesize)
+void bf_runtime_free(bf_runtime* rt)
 {
-    size_t memsize = code->size;
-    void* mem = bf_virtual_alloc(memsize);
+    rt->ctx.flush_output(&rt->ctx);
+    if (rt->guard_size != 0)
+    {
+        bf_guard_uninstall();
+        bf_virtual_free(rt->memory, rt->memory_size);
+    }
+    else
+    {
+        bf_free(rt->memory);
+    }
+    bf_runtime_close_input(&rt->ctx, rt->input_filename);
+    bf_virtual_free(rt->ctx.output_buffer, BF_OUTPUT_BUFFER_SIZE);
+}
 
-    memcpy(mem, code->data, memsize);
-    bf_virtual_make_exe(mem, memsize);
+void bf_runtime_set_input(bf_runtime* rt, const unsigned char* data, size_t size)
+{
+    rt->ctx.input_cur = data;
+    rt->ctx.input_end = data + size;
+    rt->ctx.input_eof = 1;
+}
 
-    typedef void (*compiled_func_type)(unsigned char*, unsigned char*);
-    compiled_func_type compiled_func = (compiled_func_type)mem;
+void* bf_jit_load(const bf_compiled_code* code)
+{
+    // encoded code is made executable where it was written, mapped code already is
+    if (code->mapped_size == 0)
+        bf_virtual_make_exe(code->data, code->size);
+    return code->data;
+}
 
-    unsigned char* program_memory = bf_zero_alloc(tapesize);
-    compiled_func(program_memory, program_memory + tapesize);
+void bf_jit_run(const bf_compiled_code* code, void* mem, size_t tapesize, const char* input_filename,
+                uint64_t* counters, const bf_source_map* source_map)
+{
+    bf_compiled_func compiled_func = (bf_compiled_func)mem;
 
-    bf_free(program_memory);
-    bf_virtual_free(mem, memsize);
+    bf_runtime rt;
+    bf_runtime_init(&rt, code->guard_size, tapesize, input_filename);
+    rt.ctx.counters = counters;
+    rt.ctx.source_map = source_map;
+    rt.ctx.code = mem;
+    compiled_func(rt.tape, &rt.ctx);
+    bf_runtime_free(&rt);
 }
@@ -0,0 +1,227 @@
+#include <stdint.h>
+#include <string.h>
+
+#include <emmintrin.h>
+
+#include "bfjit.h"
+#include "bfjit-bitops.h"
+#include "bfjit-io.h"
+#include "bfjit-memory.h"
+#include "bfjit-source.h"
+
+// bytes the lexer looks at in one step
+#define BF_SOURCE_BLOCK 32
+
+static void bf_source_reserve(bf_source* source, size_t count)
+{
+    if (source->size + count <= source->cap)
+        return;
+    while (source->size + count > source->cap)
+        source->cap = (source->cap == 0) ? 4096 : (source->cap * 2);
+    source->commands = bf_realloc(source->commands, source->cap);
+    source->offsets = bf_realloc(source->offsets, source->cap * sizeof(uint32_t));
+}
+
+static void bf_source_push_line(bf_source* source, uint32_t src)
+{
+    if (source->lines_size == source->lines_cap)
+    {
+        source->lines_cap = (source->lines_cap == 0) ? 256 : (source->lines_cap * 2);
+        source->lines = bf_realloc(source->lines, source->lines_cap * sizeof(uint32_t));
+    }
+    source->lines[source->lines_size++] = src;
+}
+
+// bit i is set if data[i] is a command or a newline
+static uint32_t bf_source_classify16(const unsigned char* data)
+{
+    __m128i x = _mm_loadu_si128((const __m128i*)data);
+    // "+,-." are consecutive, x - '+' is at most 3 for them
+    __m128i d = _mm_sub_epi8(x, _mm_set1_epi8('+'));
+    __m128i m = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(3)), d);
+    // '<' and '>' differ only in bit 1
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_or_si128(x, _mm_set1_epi8(2)), _mm_set1_epi8('>')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('[')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8(']')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('\n')));
+    return (uint32_t)_mm_movemask_epi8(m);
+}
+
+// lexes a whole block starting at source offset 'base'
+static void bf_source_lex_block(bf_source* source, const unsigned char* block, size_t base)
+{
+    uint32_t mask = bf_source_classify16(block) | (bf_source_classify16(block + 16) << 16);
+    // comments are skipped a block at a time
+    if (mask == 0)
+        return;
+    bf_source_reserve(source, BF_SOURCE_BLOCK);
+    do
+    {
+        unsigned i = bf_ctz(mask);
+        mask &= mask - 1;
+        uint32_t src = (uint32_t)(base + i);
+        if (block[i] == '\n')
+        {
+            bf_source_push_line(source, src + 1);
+        }
+        else
+        {
+            source->commands[source->size] = block[i];
+            source->offsets[source->size] = src;
+            source->size += 1;
+        }
+    } while (mask != 0);
+}
+
+static void bf_source_lex(bf_source* source, const unsigned char* data, size_t size)
+{
+    size_t i = 0;
+    for (; size - i >= BF_SOURCE_BLOCK; i += BF_SOURCE_BLOCK)
+        bf_source_lex_block(source, data + i, i);
+    // the rest is padded with zeros, which aren't commands
+    if (i != size)
+    {
+        unsigned char tail[BF_SOURCE_BLOCK] = {0};
+        memcpy(tail, data + i, size - i);
+        bf_source_lex_block(source, tail, i);
+    }
+}
+
+static void bf_source_check_brackets(const bf_source* source)
+{
+    size_t depth = 0;
+    for (size_t i = 0; i != source->size; ++i)
+    {
+        if (source->commands[i] == '[')
+        {
+            depth += 1;
+        }
+        else if (source->commands[i] == ']')
+        {
+            if (depth == 0)
+                bf_error("']' without a matching '['");
+            depth -= 1;
+        }
+    }
+    if (depth != 0)
+        bf_error("'[' without a matching ']'");
+}
+
+void bf_source_load(bf_source* source, const char* filename)
+{
+    source->commands = NULL;
+    source->offsets = NULL;
+    source->size = 0;
+    source->cap = 0;
+    source->lines = NULL;
+    source->lines_size = 0;
+    source->lines_cap = 0;
+
+    bf_file file = bf_open_file_read(filename);
+    size_t size;
+    unsigned char* data = bf_map_file(file, &size);
+    int mapped = data != NULL;
+    if (!mapped)
+    {
+        // pipes and empty files are read whole
+        size_t cap = 64 * 1024;
+        size_t read;
+        data = bf_realloc(NULL, cap);
+        size = 0;
+        while ((read = bf_read_file(file, data + size, cap - size)) != 0)
+        {
+            size += read;
+            if (size == cap)
+            {
+                cap *= 2;
+                data = bf_realloc(data, cap);
+            }
+        }
+    }
+    if (size > UINT32_MAX)
+        bf_error("source file '%s' is too large", filename);
+
+    bf_source_lex(source, data, size);
+
+    if (mapped)
+        bf_unmap_file(data, size);
+    else
+        bf_free(data);
+    bf_close_file(file);
+    bf_source_check_brackets(source);
+}
+
+void bf_source_free(bf_source* source)
+{
+    bf_free(source->commands);
+    bf_free(source->offsets);
+    bf_free(source->lines);
+}
+
+void bf_source_map_init(bf_source_map* map)
+{
+    map->positions = NULL;
+    map->size = 0;
+    map->cap = 0;
+}
+
+void bf_source_map_free(bf_source_map* map)
+{
+    bf_free(map->positions);
+    bf_source_map_init(map);
+}
+
+void bf_source_map_push(bf_source_map* map, size_t offset, uint32_t line, uint32_t col)
+{
+    if (map->size != 0)
+    {
+        bf_source_pos* last = &map->positions[map->size - 1];
+        if (last->line == line && last->col == col)
+            return;
+        // ops that didn't emit any code
+        if (last->offset == offset)
+        {
+            last->line = line;
+            last->col = col;
+            return;
+        }
+    }
+    if (map->size == map->cap)
+    {
+        map->cap = (map->cap == 0) ? 256 : (map->cap * 2);
+        map->positions = bf_realloc(map->positions, map->cap * sizeof(bf_source_pos));
+    }
+    bf_source_pos* p = &map->positions[map->size++];
+    p->offset = offset;
+    p->line = line;
+    p->col = col;
+}
+
+void bf_source_map_append(bf_source_map* map, const bf_source_map* part, size_t base)
+{
+    for (size_t i = 0; i != part->size; ++i)
+    {
+        const bf_source_pos* p = &part->positions[i];
+        bf_source_map_push(map, base + p->offset, p->line, p->col);
+    }
+}
+
+int bf_source_map_find(const bf_source_map* map, size_t offset, uint32_t* line, uint32_t* col)
+{
+    // positions starting at or before 'offset'
+    size_t lo = 0;
+    size_t hi = map->size;
+    while (lo != hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (map->positions[mid].offset <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+        return 0;
+    *line = map->positions[lo - 1].line;
+    *col = map->positions[lo - 1].col;
+    return 1;
+}
@@ -0,0 +1,134 @@
+#include <stddef.h>
+#include <stdint.h>
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <intrin.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "bfjit.h"
+#include "bfjit-memory.h"
+#include "bfjit-thread.h"
+
+typedef struct {
+    bf_thread_func func;
+    void* arg;
+#ifndef _WIN32
+    pthread_t thread;
+#endif
+} bf_thread_start_data;
+
+#ifdef _WIN32
+static DWORD WINAPI bf_thread_main(LPVOID arg)
+{
+    bf_thread_start_data data = *(bf_thread_start_data*)arg;
+    bf_free(arg);
+    data.func(data.arg);
+    return 0;
+}
+
+bf_thread bf_thread_start(bf_thread_func func, void* arg)
+{
+    bf_thread_start_data* data = bf_realloc(NULL, sizeof(bf_thread_start_data));
+    data->func = func;
+    data->arg = arg;
+    HANDLE thread = CreateThread(NULL, 0, bf_thread_main, data, 0, NULL);
+    if (!thread)
+        bf_error("couldn't start thread");
+    return thread;
+}
+
+void bf_thread_join(bf_thread thread)
+{
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+size_t bf_cpu_count(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+}
+
+static size_t bf_fetch_inc(size_t* p)
+{
+    return (size_t)_InterlockedExchangeAdd64((volatile __int64*)p, 1);
+}
+#else
+static void* bf_thread_main(void* arg)
+{
+    bf_thread_start_data* data = arg;
+    data->func(data->arg);
+    return NULL;
+}
+
+// the start data stands in for the thread, it is freed once the thread is joined
+bf_thread bf_thread_start(bf_thread_func func, void* arg)
+{
+    bf_thread_start_data* data = bf_realloc(NULL, sizeof(bf_thread_start_data));
+    data->func = func;
+    data->arg = arg;
+    if (pthread_create(&data->thread, NULL, bf_thread_main, data) != 0)
+        bf_error("couldn't start thread");
+    return data;
+}
+
+void bf_thread_join(bf_thread thread)
+{
+    bf_thread_start_data* data = thread;
+    pthread_join(data->thread, NULL);
+    bf_free(data);
+}
+
+size_t bf_cpu_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (size_t)count : 1;
+}
+
+static size_t bf_fetch_inc(size_t* p)
+{
+    return __atomic_fetch_add(p, 1, __ATOMIC_RELAXED);
+}
+#endif
+
+typedef struct {
+    bf_parallel_func func;
+    void* arg;
+    size_t count;
+    size_t next;
+} bf_parallel_ctx;
+
+static void bf_parallel_worker(void* arg)
+{
+    bf_parallel_ctx* ctx = arg;
+    size_t i;
+    while ((i = bf_fetch_inc(&ctx->next)) < ctx->count)
+        ctx->func(ctx->arg, i);
+}
+
+void bf_parallel_for(size_t count, size_t threads, bf_parallel_func func, void* arg)
+{
+    bf_parallel_ctx ctx;
+    ctx.func = func;
+    ctx.arg = arg;
+    ctx.count = count;
+    ctx.next = 0;
+
+    if (threads > count)
+        threads = count;
+    bf_thread* workers = NULL;
+    if (threads > 1)
+        workers = bf_realloc(NULL, (threads - 1) * sizeof(bf_thread));
+    for (size_t i = 1; i < threads; ++i)
+        workers[i - 1] = bf_thread_start(bf_parallel_worker, &ctx);
+    bf_parallel_worker(&ctx);
+    for (size_t i = 1; i < threads; ++i)
+        bf_thread_join(workers[i - 1]);
+    bf_free(workers);
+}
@@ -0,0 +1,318 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bfjit.h"
+#include "bfjit-compiler.h"
+#include "bfjit-memory.h"
+#include "bfjit-runtime.h"
+#include "bfjit-thread.h"
+#include "bfjit-tiered.h"
+
+/*
+ *  Interpreter
+ */
+
+typedef enum {
+    BF_OP_ADD,          // cell += arg
+    BF_OP_MOVE,         // ptr += arg
+    BF_OP_CLEAR,        // cell = 0
+    BF_OP_OUTPUT,       // write(cell) arg times
+    BF_OP_INPUT,        // cell = read()
+    BF_OP_LOOP,         // if (!cell) goto END at 'link'
+    BF_OP_END,          // if (cell) goto LOOP at 'link'
+    BF_OP_HALT,
+} bf_op_kind;
+
+typedef struct {
+    uint32_t kind;
+    int32_t arg;
+    uint32_t link;
+    uint32_t osr;       // LOOP: index of its osr entry plus one, zero if it has none
+    uint32_t src;       // LOOP: source offset of the '['
+} bf_op;
+
+typedef struct {
+    bf_op* ops;
+    size_t size;
+    size_t cap;
+} bf_program;
+
+static size_t bf_program_push(bf_program* prog, bf_op_kind kind, int32_t arg, uint32_t src)
+{
+    if (prog->size == prog->cap)
+    {
+        prog->cap = (prog->cap == 0) ? 256 : (prog->cap * 2);
+        prog->ops = bf_realloc(prog->ops, prog->cap * sizeof(bf_op));
+    }
+    bf_op* op = &prog->ops[prog->size];
+    op->kind = kind;
+    op->arg = arg;
+    op->link = 0;
+    op->osr = 0;
+    op->src = src;
+    return prog->size++;
+}
+
+// parsed ir has only merged runs, i/o and loops with matched brackets
+static void bf_program_init(bf_program* prog, const bf_ir* ir)
+{
+    prog->ops = NULL;
+    prog->size = 0;
+    prog->cap = 0;
+    uint32_t* loops = NULL;
+    size_t loops_size = 0;
+    size_t loops_cap = 0;
+    for (size_t i = 0; i != ir->size; ++i)
+    {
+        const bf_ir_op* op = &ir->ops[i];
+        switch (op->kind)
+        {
+        case BF_IR_ADD:
+            bf_program_push(prog, BF_OP_ADD, op->val, 0);
+            break;
+        case BF_IR_MOVE:
+            bf_program_push(prog, BF_OP_MOVE, op->val, 0);
+            break;
+        case BF_IR_OUTPUT:
+            bf_program_push(prog, BF_OP_OUTPUT, op->val, 0);
+            break;
+        case BF_IR_INPUT:
+            bf_program_push(prog, BF_OP_INPUT, 0, 0);
+            break;
+        case BF_IR_LOOP:
+            if (op[1].kind == BF_IR_ADD && (op[1].val == 1 || op[1].val == -1) && op[2].kind == BF_IR_END)
+            {
+                bf_program_push(prog, BF_OP_CLEAR, 0, 0);
+                i += 2;
+                break;
+            }
+            if (loops_size == loops_cap)
+            {
+                loops_cap = (loops_cap == 0) ? 16 : (loops_cap * 2);
+                loops = bf_realloc(loops, loops_cap * sizeof(uint32_t));
+            }
+            loops[loops_size++] = (uint32_t)bf_program_push(prog, BF_OP_LOOP, 0, op->src);
+            break;
+        case BF_IR_END:
+        {
+            assert(loops_size != 0);
+            uint32_t begin = loops[--loops_size];
+            uint32_t end = (uint32_t)bf_program_push(prog, BF_OP_END, 0, 0);
+            prog->ops[begin].link = end;
+            prog->ops[end].link = begin;
+            break;
+        }
+        default:
+            assert(0);
+        }
+    }
+    bf_program_push(prog, BF_OP_HALT, 0, 0);
+    bf_free(loops);
+}
+
+/*
+ *  Background compilation
+ */
+
+typedef struct {
+    bf_ir ir;
+    bf_ir_options opts;
+    bf_jit_encoder* enc;
+    bf_osr_table osr;
+    bf_compiled_code code;
+    int ready;
+} bf_compile_job;
+
+static void bf_compile_job_run(void* arg)
+{
+    bf_compile_job* job = arg;
+    bf_compile_info info = {&job->osr, NULL, NULL, NULL};
+    job->code = bf_compile_ir(&job->ir, job->enc, &job->opts, &info);
+    bf_ir_free(&job->ir);
+    bf_store_release(&job->ready, 1);
+}
+
+/*
+ *  Switching to compiled code
+ */
+
+typedef void (*bf_osr_func)(unsigned char* ptr, bf_runtime_context* ctx, const void* entry);
+
+typedef struct {
+    bf_compile_job* job;
+    void* mem;          // loaded code, NULL until the job is done
+    int rtc;
+} bf_tier_state;
+
+static int bf_osr_entry_cmp(const void* a, const void* b)
+{
+    uint32_t x = ((const bf_osr_entry*)a)->src;
+    uint32_t y = ((const bf_osr_entry*)b)->src;
+    return (x > y) - (x < y);
+}
+
+// links loops of the program to the entries for the same source bracket,
+// loops the optimizer removed or duplicated keep being interpreted
+static void bf_program_link_osr(bf_program* prog, bf_osr_table* osr)
+{
+    qsort(osr->entries, osr->size, sizeof(bf_osr_entry), bf_osr_entry_cmp);
+    for (size_t i = 0; i != prog->size; ++i)
+    {
+        bf_op* op = &prog->ops[i];
+        if (op->kind != BF_OP_LOOP)
+            continue;
+
+        size_t lo = 0;
+        size_t hi = osr->size;
+        while (lo != hi)
+        {
+            size_t mid = lo + (hi - lo) / 2;
+            if (osr->entries[mid].src < op->src)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo != osr->size && osr->entries[lo].src == op->src &&
+            (lo + 1 == osr->size || osr->entries[lo + 1].src != op->src))
+            op->osr = (uint32_t)lo + 1;
+    }
+}
+
+// continues the program in compiled code from the start of 'loop', returns
+// 0 if it can't be entered there
+static int bf_osr_enter(bf_tier_state* tier, const bf_op* loop, unsigned char* ptr, bf_runtime_context* ctx)
+{
+    if (loop->osr == 0)
+        return 0;
+    const bf_osr_entry* e = &tier->job->osr.entries[loop->osr - 1];
+    if (tier->rtc != BF_CHECK_NONE)
+    {
+        ptrdiff_t pos = ptr - ctx->tape_begin;
+        if (pos + e->lo < 0 || pos + e->hi >= ctx->tape_end - ctx->tape_begin)
+            return 0;
+    }
+    const unsigned char* base = tier->mem;
+    bf_osr_func osr = (bf_osr_func)(base + tier->job->code.osr_entry);
+    osr(ptr, ctx, base + e->entry);
+    return 1;
+}
+
+#ifdef __GNUC__
+#define BF_CASE(kind) label_##kind:
+#define BF_DISPATCH() goto *labels[pc->kind]
+#else
+#define BF_CASE(kind) case kind:
+#define BF_DISPATCH() goto dispatch
+#endif
+#define BF_NEXT() do { ++pc; BF_DISPATCH(); } while (0)
+
+static void bf_interpret(bf_program* prog, bf_tier_state* tier, int eof, unsigned char* ptr, bf_runtime_context* ctx)
+{
+    const bf_op* pc = prog->ops;
+    int check = tier->rtc != BF_CHECK_NONE;
+
+#ifdef __GNUC__
+    static const void* const labels[] = {
+        &&label_BF_OP_ADD, &&label_BF_OP_MOVE, &&label_BF_OP_CLEAR, &&label_BF_OP_OUTPUT,
+        &&label_BF_OP_INPUT, &&label_BF_OP_LOOP, &&label_BF_OP_END, &&label_BF_OP_HALT,
+    };
+    BF_DISPATCH();
+#else
+dispatch:
+    switch (pc->kind)
+#endif
+    {
+    BF_CASE(BF_OP_ADD)
+        *ptr = (unsigned char)(*ptr + pc->arg);
+        BF_NEXT();
+    BF_CASE(BF_OP_MOVE)
+        ptr += pc->arg;
+        if (check && (ptr < ctx->tape_begin || ptr >= ctx->tape_end))
+            ctx->out_of_bounds(ctx, ptr, NULL);
+        BF_NEXT();
+    BF_CASE(BF_OP_CLEAR)
+        *ptr = 0;
+        BF_NEXT();
+    BF_CASE(BF_OP_OUTPUT)
+        for (int32_t i = 0; i != pc->arg; ++i)
+        {
+            *ctx->output_cur++ = *ptr;
+            // the buffer is aligned to its size
+            if (((uintptr_t)ctx->output_cur & (BF_OUTPUT_BUFFER_SIZE - 1)) == 0)
+                ctx->flush_output(ctx);
+        }
+        BF_NEXT();
+    BF_CASE(BF_OP_INPUT)
+        if (ctx->input_cur != ctx->input_end)
+            *ptr = *ctx->input_cur++;
+        else if (eof == 0)
+            *ptr = ctx->read_char_eof_zero(ctx);
+        else if (eof == -1)
+            *ptr = ctx->read_char_eof_minusone(ctx);
+        else
+            *ptr = ctx->read_char_eof_nochange(ctx, *ptr);
+        BF_NEXT();
+    BF_CASE(BF_OP_LOOP)
+        if (*ptr == 0)
+            pc = &prog->ops[pc->link];
+        BF_NEXT();
+    BF_CASE(BF_OP_END)
+        if (*ptr == 0)
+            BF_NEXT();
+        pc = &prog->ops[pc->link];
+        if (bf_load_acquire(&tier->job->ready))
+        {
+            if (!tier->mem)
+            {
+                tier->mem = bf_jit_load(&tier->job->code);
+                bf_program_link_osr(prog, &tier->job->osr);
+            }
+            if (bf_osr_enter(tier, pc, ptr, ctx))
+                return;
+        }
+        BF_NEXT();
+    BF_CASE(BF_OP_HALT)
+        return;
+    }
+}
+
+#undef BF_CASE
+#undef BF_DISPATCH
+#undef BF_NEXT
+
+bf_compiled_code bf_run_tiered(const char* filename, bf_jit_encoder* enc, const bf_ir_options* opts, int eof,
+                               size_t tapesize, const char* input_filename)
+{
+    assert(opts->rtc != BF_CHECK_GUARD);
+    bf_compile_job job;
+    bf_ir_init(&job.ir);
+    bf_ir_parse_file(filename, &job.ir);
+    job.opts = *opts;
+    // the interpreter runs the start of the program before the code is ready
+    job.opts.eval_prefix = 0;
+    job.enc = enc;
+    job.osr.entries = NULL;
+    job.osr.size = 0;
+    job.osr.cap = 0;
+    job.ready = 0;
+
+    bf_program prog;
+    bf_program_init(&prog, &job.ir);
+    bf_thread thread = bf_thread_start(bf_compile_job_run, &job);
+
+    bf_tier_state tier;
+    tier.job = &job;
+    tier.mem = NULL;
+    tier.rtc = opts->rtc;
+    bf_runtime rt;
+    bf_runtime_init(&rt, 0, tapesize, input_filename);
+    bf_interpret(&prog, &tier, eof, rt.tape, &rt.ctx);
+    bf_runtime_free(&rt);
+
+    bf_thread_join(thread);
+    bf_free(job.osr.entries);
+    bf_free(prog.ops);
+    return job.code;
+}
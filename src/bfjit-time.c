@@ -1,18 +1,30 @@
 #include <time.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 #include "bfjit.h"
 #include "bfjit-time.h"
 
 int64_t bf_clock(void)
 {
-#if defined TIME_UTC || defined CLOCK_REALTIME
+#if defined _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return count.QuadPart / freq.QuadPart * 1000000 + count.QuadPart % freq.QuadPart * 1000000 / freq.QuadPart;
+#else
+#if defined CLOCK_MONOTONIC
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#elif defined TIME_UTC
+    // wall clock, may jump while measuring
     struct timespec ts;
-#if defined TIME_UTC
     if (timespec_get(&ts, TIME_UTC) != 0)
-#else
-    if (clock_gettime(CLOCK_REALTIME, &ts) == 0)
-#endif
         return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
 #endif
     bf_error("system has no compatible clock");
+#endif
 }
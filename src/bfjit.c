@@ -5,16 +5,26 @@
 #include <time.h>
 
 #include "bfjit.h"
+#include "bfjit-aot.h"
+#include "bfjit-batch.h"
+#include "bfjit-cache.h"
 #include "bfjit-compiler.h"
+#include "bfjit-guard.h"
 #include "bfjit-io.h"
 #include "bfjit-memory.h"
+#include "bfjit-perf.h"
+#include "bfjit-profile.h"
 #include "bfjit-runtime.h"
+#include "bfjit-thread.h"
+#include "bfjit-tiered.h"
 #include "bfjit-time.h"
 
 static void bf_print_help(const char* argv0)
 {
-    printf("usage: %s <filename> [--unsafe|-u] [--debug|-d]\n"
-           "  [--eof (0|-1|nochange)] [--time|-t] [--tape-size <number>] [--dump <filename>]\n",
+    printf("usage: %s <filename> [--unsafe|-u] [--guard-pages|-g] [--debug|-d] [-O0|-O1|-O2|-O3]\n"
+           "  [--eof (0|-1|nochange)] [--time|-t] [--tape-size <number>|unbounded] [--dump <filename>]\n"
+           "  [--input <filename>] [--cache <directory>] [--clear-cache] [--aot <filename>] [--tiered]\n"
+           "  [--profile] [--perf-map] [--jitdump] [--jobs <number>] [--batch <filename>]\n",
            argv0);
 }
 
@@ -24,12 +34,24 @@ int main(int argc, char** argv)
 {
     const char* source_file = NULL;
     int debug_opt = 0;
-    int check_opt = 1;
+    int check_opt = BF_CHECK_INLINE;
     size_t tape_size = 30000;
     int eof_opt = 0;
     int dump_opt = 0;
     const char* dumpfile = NULL;
+    const char* input_file = NULL;
     int measure_opt = 0;
+    int opt_level = 2;
+    const char* cache_dir = NULL;
+    int clear_cache_opt = 0;
+    const char* aot_file = NULL;
+    int tiered_opt = 0;
+    int profile_opt = 0;
+    bf_profile profile;
+    int perf_map_opt = 0;
+    int jitdump_opt = 0;
+    size_t jobs = 0;
+    const char* batch_file = NULL;
 
     int64_t t1 = 0, t2 = 0, t3 = 0;
 
@@ -48,18 +70,33 @@ int main(int argc, char** argv)
         }
         else if (bf_streq(argv[i], "--unsafe") || bf_streq(argv[i], "-u"))
         {
-            check_opt = 0;
+            check_opt = BF_CHECK_NONE;
+        }
+        else if (bf_streq(argv[i], "--guard-pages") || bf_streq(argv[i], "-g"))
+        {
+#ifdef BF_HAVE_GUARD_PAGES
+            check_opt = BF_CHECK_GUARD;
+#else
+            bf_error("'--guard-pages' option is not supported on this platform");
+#endif
         }
         else if (bf_streq(argv[i], "--tape-size"))
         {
             next_arg();
-            errno = 0;
-            char* end;
-            long long tmp = strtoll(argv[i], &end, 10);
-            if (*end != '\0' || errno != 0 || tmp <= 0)
-                bf_error("invalid argument to '--tape-size' option");
+            if (bf_streq(argv[i], "unbounded"))
+            {
+                tape_size = BF_TAPE_UNBOUNDED;
+            }
+            else
+            {
+                errno = 0;
+                char* end;
+                long long tmp = strtoll(argv[i], &end, 10);
+                if (*end != '\0' || errno != 0 || tmp <= 0)
+                    bf_error("invalid argument to '--tape-size' option");
 
-            tape_size = (size_t)tmp;
+                tape_size = (size_t)tmp;
+            }
         }
         else if (bf_streq(argv[i], "--eof"))
         {
@@ -79,10 +116,72 @@ int main(int argc, char** argv)
             dump_opt = 1;
             dumpfile = argv[i];
         }
+        else if (bf_streq(argv[i], "--aot"))
+        {
+            next_arg();
+#ifdef _WIN32
+            bf_error("'--aot' option is not supported on this platform");
+#endif
+            aot_file = argv[i];
+        }
+        else if (bf_streq(argv[i], "--input"))
+        {
+            next_arg();
+            input_file = argv[i];
+        }
+        else if (bf_streq(argv[i], "--batch"))
+        {
+            next_arg();
+            batch_file = argv[i];
+        }
+        else if (bf_streq(argv[i], "--cache"))
+        {
+            next_arg();
+            cache_dir = argv[i];
+        }
+        else if (bf_streq(argv[i], "--clear-cache"))
+        {
+            clear_cache_opt = 1;
+        }
+        else if (bf_streq(argv[i], "--tiered"))
+        {
+            tiered_opt = 1;
+        }
+        else if (bf_streq(argv[i], "--profile"))
+        {
+            profile_opt = 1;
+        }
+        else if (bf_streq(argv[i], "--perf-map") || bf_streq(argv[i], "--jitdump"))
+        {
+#ifdef BF_HAVE_PERF
+            if (bf_streq(argv[i], "--perf-map"))
+                perf_map_opt = 1;
+            else
+                jitdump_opt = 1;
+#else
+            bf_error("'%s' option is not supported on this platform", argv[i]);
+#endif
+        }
+        else if (bf_streq(argv[i], "--jobs") || bf_streq(argv[i], "-j"))
+        {
+            next_arg();
+            errno = 0;
+            char* end;
+            long long tmp = strtoll(argv[i], &end, 10);
+            if (*end != '\0' || errno != 0 || tmp <= 0)
+                bf_error("invalid argument to '--jobs' option");
+
+            jobs = (size_t)tmp;
+        }
         else if (bf_streq(argv[i], "--time") || bf_streq(argv[i], "-t"))
         {
             measure_opt = 1;
         }
+        else if (argv[i][0] == '-' && argv[i][1] == 'O' && argv[i][2] >= '0' && argv[i][2] <= '3' &&
+                 argv[i][3] == '\0')
+        {
+            opt_level = argv[i][2] - '0';
+        }
         else if (argv[i][0] == '-')
         {
             bf_error("unknown command line argument: '%s'", argv[i]);
@@ -96,31 +195,156 @@ int main(int argc, char** argv)
 #undef next_arg
     }
 
+    if (clear_cache_opt)
+    {
+        if (cache_dir == NULL)
+            bf_error("'--clear-cache' option requires '--cache' option");
+        bf_cache_clear(cache_dir);
+        if (source_file == NULL)
+            return 0;
+    }
     if (source_file == NULL)
         bf_error("no source file specified");
     if (debug_opt && !check_opt)
         bf_error("'--unsafe' option is not supported in debug mode");
+    if (tape_size == BF_TAPE_UNBOUNDED)
+    {
+#ifndef BF_HAVE_GUARD_PAGES
+        bf_error("unbounded tape is not supported on this platform");
+#endif
+        if (!check_opt)
+            bf_error("'--unsafe' option is not supported with unbounded tape");
+        // pages of the tape are committed when compiled code faults on them
+        check_opt = BF_CHECK_GUARD;
+    }
+    if (aot_file)
+    {
+        if (check_opt == BF_CHECK_GUARD)
+            bf_error("'--aot' option is not supported with guard pages");
+        if (cache_dir)
+            bf_error("'--aot' option is not supported with '--cache' option");
+    }
+    if (tiered_opt)
+    {
+        if (check_opt == BF_CHECK_GUARD)
+            bf_error("'--tiered' option is not supported with guard pages");
+        if (debug_opt)
+            bf_error("'--tiered' option is not supported in debug mode");
+        if (dump_opt || aot_file)
+            bf_error("'--tiered' option is not supported with '--dump' and '--aot' options");
+    }
+    if (profile_opt)
+    {
+        if (debug_opt)
+            bf_error("'--profile' option is not supported in debug mode");
+        if (tiered_opt || aot_file || cache_dir)
+            bf_error("'--profile' option is not supported with '--tiered', '--aot' and '--cache' options");
+    }
+    if (batch_file)
+    {
+        if (input_file)
+            bf_error("'--batch' option is not supported with '--input' option");
+        if (tiered_opt || aot_file || dump_opt)
+            bf_error("'--batch' option is not supported with '--tiered', '--aot' and '--dump' options");
+        if (profile_opt)
+            bf_error("'--batch' option is not supported with '--profile' option");
+    }
+    if ((perf_map_opt || jitdump_opt) && tiered_opt)
+        bf_error("'--perf-map' and '--jitdump' options are not supported with '--tiered' option");
+
+    // a missing list is reported before compiling
+    bf_batch_list batch;
+    if (batch_file)
+        bf_batch_list_load(&batch, batch_file);
+    size_t batch_failed = 0;
 
     if (measure_opt)
         t1 = bf_clock();
 
     bf_jit_encoder* enc = bf_jit_encoder_new(check_opt, eof_opt);
+    // executables may run on other machines
+    if (aot_file)
+        bf_jit_encoder_set_avx2(enc, 0);
     bf_compiled_code code;
-    if (debug_opt)
-        code = bf_compile_file_debug(source_file, enc);
-    else
-        code = bf_compile_file(source_file, enc);
+    bf_cache_key key;
+    int cache_hit = 0;
+    if (cache_dir)
+    {
+        bf_cache_key_init(&key, source_file, opt_level, check_opt, eof_opt, debug_opt);
+        cache_hit = bf_cache_load(cache_dir, &key, &code);
+    }
+    // the program runs while it is compiled, so compile time isn't measured separately
+    int tiered = tiered_opt && !cache_hit;
+    if (measure_opt && tiered)
+        t2 = bf_clock();
+    // code of a cache hit or the debug compiler is a single symbol
+    bf_code_map code_map;
+    bf_code_map_init(&code_map);
+    // checks of the code report the source position they fail at
+    bf_source_map source_map;
+    bf_source_map_init(&source_map);
+    if (!cache_hit)
+    {
+        bf_ir_options opts;
+        opts.opt_level = opt_level;
+        opts.rtc = check_opt;
+        opts.continued = 0;
+        opts.jobs = jobs;
+        // profiles count loops of the program as it is written
+        opts.eval_prefix = !profile_opt;
+        bf_compile_info info;
+        info.osr = NULL;
+        info.profile = profile_opt ? &profile : NULL;
+        info.code_map = (perf_map_opt || jitdump_opt) ? &code_map : NULL;
+        info.source_map = (check_opt && !aot_file && !dump_opt) ? &source_map : NULL;
+        if (debug_opt)
+            code = bf_compile_file_debug(source_file, enc);
+        else if (tiered)
+            code = bf_run_tiered(source_file, enc, &opts, eof_opt, tape_size, input_file);
+        else
+            code = bf_compile_file(source_file, enc, &opts, &info);
+        if (cache_dir)
+            bf_cache_store(cache_dir, &key, &code);
+    }
 
-    if (measure_opt)
+    if (measure_opt && !tiered)
         t2 = bf_clock();
+    size_t code_size = code.size;
+    bf_peephole_stats peephole = *bf_jit_encoder_peephole(enc);
 
-    if (!dump_opt)
-        bf_jit_run(&code, tape_size);
-    else
+    if (aot_file)
+        bf_aot_write(aot_file, &code, tape_size);
+    else if (dump_opt)
         bf_save_to_file(dumpfile, code.data, code.size);
+    else if (!tiered)
+    {
+        void* mem = bf_jit_load(&code);
+#ifdef BF_HAVE_PERF
+        if (perf_map_opt)
+            bf_perf_write_map(&code_map, mem, code.size);
+        if (jitdump_opt)
+            bf_perf_write_jitdump(&code_map, mem, code.size, source_file);
+#endif
+        if (batch_file)
+            batch_failed = bf_batch_run(&code, mem, tape_size, &batch, jobs ? jobs : bf_cpu_count(), &source_map);
+        else
+            bf_jit_run(&code, mem, tape_size, input_file, profile_opt ? profile.counters : NULL, &source_map);
+    }
+    bf_code_map_free(&code_map);
+    bf_source_map_free(&source_map);
 
     bf_jit_encoder_free(enc);
-    bf_free(code.data);
+    if (cache_hit)
+        bf_cache_unload(&code);
+    else
+        bf_compiled_code_free(&code);
+
+    if (profile_opt)
+    {
+        if (!dump_opt)
+            bf_profile_report(&profile);
+        bf_profile_free(&profile);
+    }
 
     if (measure_opt)
     {
@@ -133,6 +357,15 @@ int main(int argc, char** argv)
                "Execution time: %f sec.\n"
                "Total:          %f sec.\n",
                diff1, diff2, diff1 + diff2);
+        if (cache_dir)
+            printf("Code cache:     %s\n", cache_hit ? "hit" : "miss");
+        printf("Code size:      %zu bytes\n", code_size);
+        if (!cache_hit)
+            printf("Peephole:       %zu flag tests, %zu bytes left out\n", peephole.flag_tests, peephole.bytes);
+        if (batch_file)
+            printf("Batch:          %zu runs, %zu failed\n", batch.size, batch_failed);
     }
-    return 0;
+    if (batch_file)
+        bf_batch_list_free(&batch);
+    return batch_failed != 0;
 }
@@ -0,0 +1,14 @@
+Multiply loops by four and seven and eight and loops ending right after
+arithmetic on the current cell
+Prints the results as letters
+
+factors four and seven and eight
+,[->++++>+++++++>++++++++<<<]>+.>+.>+.>>
+negative factors four and seven and eight
+,[->---->------->--------<<<]>+.>+.>+.>>
+factors four and seven and eight in a loop keeping cells in registers
+,>,<[>[->++++>+++++++>++++++++>+<<<<]>>>>[-<<<<+>>>>]<<<<<-]>>.>.>.>>>
+loop ending right after subtracting from the current cell
+,>,[<+.>--]>>
+loop ending right after adding to the current cell
+,>,[<-.>++++++]>>
@@ -0,0 +1,20 @@
+Multiply loops with counters stepping by values other than minus one and
+nested multiply loops on values read from input
+Prints the results as letters
+
+counter stepping by minus three
+,[--->+<]>.>>
+counter stepping by plus one
+,[+>++>-<<]>.>.>>
+counter stepping by minus four with all multiples divisible by four
+,[---->++++++++>++++<<]>.>.>>
+counter stepping by minus two with an odd multiple
+,[-->+++<]>.>>
+nested copy loops multiplying two cells
+,>,<[>[->+>+<<]>>[-<<+>>]<<<-]>>.<.>>>>
+nested copy loops with the counter stepping by minus three
+,>,<[--->[->+++>+<<]>>[-<<+>>]<<<]>>.<.>>>>
+nested clear
+,[->+++>[-]<<]>.>>>
+nested copy loops subtracting the product
+,>,<[>[->->+<<]>>[-<<+>>]<<<-]>>.<.
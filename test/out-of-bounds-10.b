@@ -0,0 +1,2 @@
+Output of the part run at compile time comes ahead of its checks
+++++++++[>++++++++<-]>+.<<+
@@ -0,0 +1,3 @@
+Scan with a stride too long for SIMD compares runs off the start of the tape
++>>>>>>>>>>+>>>>>>>>>>+>>>>>>>>>>+>>>>>>>>>>+>>>>>>>>>>+>>>>>>>>>>+>>>>>>>>>>+>>>>>>>>>>+>>>>>>>>>>+>>>>>>>>>>+
+[<<<<<<<<<<].
@@ -0,0 +1,2 @@
+A loop on a cell no access has shown to be on the tape is known not to run
+><[-+[+---[+]---]]<<[----->>><<<]>>>>>.++++
@@ -0,0 +1,2 @@
+Cells behind the start of the tape are not known to be zero
+>++.[-------<<[+++++]>>]----->[-].[.<]
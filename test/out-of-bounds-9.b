@@ -0,0 +1,4 @@
+Output written before an access off the tape is not held back by its check
+,>>->
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.
+<<<<<>----
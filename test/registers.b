@@ -0,0 +1,11 @@
+cached cells: a loop that keeps the cells to the right of its counter in
+registers while it writes enough output to flush the buffer
+++++++++[>>>++++++++++++<<<-]
+>>>>++++[>++++++++<-]<<<<
+-[
+    >+>+++<<
+    >>>.+.+.+.+.+.------
+    ............+<<<
+    >>>>>[-<<<+>>>]<<<<<
+-]
+>++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.>+++++++++++++++++++++++++++++++++++++.>.>++++++++++.
@@ -0,0 +1,2 @@
+A vector scan stopping at the last cell of the tape
+,[-]+>>+>>+>>+>>+>>+>>+>>+<<<<<<<<<<<<<<[>>]++++++++[<++++++++>-]<+.
@@ -0,0 +1,2 @@
+A backward vector scan stopping at the first cell of the tape
+,[-]>>+>>+>>+>>+>>+>>+>>+>>+[<<]+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++.
@@ -0,0 +1,3 @@
+the cell that ends a scan has to be written back when the scan is skipped
+>>,[+++[>]<]
++++++++[<+++++++>-]<[->+<]>+[.>]++++++++++.